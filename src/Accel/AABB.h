@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "../Vector/Vector3.h"
+
+namespace rt {
+    inline float Component(Vector3<float> const& v, int axis) {
+        return axis == 0 ? v.X : (axis == 1 ? v.Y : v.Z);
+    }
+
+    inline void SetComponent(Vector3<float>& v, int axis, float value) {
+        (axis == 0 ? v.X : (axis == 1 ? v.Y : v.Z)) = value;
+    }
+
+    // Reciprocal direction for slab tests. Zero components become a huge finite value
+    // instead of infinity, so 0 * inverse never produces NaN.
+    inline Vector3<float> InverseDirection(Vector3<float> const& direction) {
+        auto inverse = [](float value) {
+            return 1.f / (std::fabs(value) > 1e-20f ? value : std::copysign(1e-20f, value));
+        };
+        return Vector3<float>(inverse(direction.X), inverse(direction.Y), inverse(direction.Z));
+    }
+
+    // Axis-aligned bounding box, empty until grown.
+    struct AABB {
+        Vector3<float>  Min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        Vector3<float>  Max{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+        void    Grow(Vector3<float> const& point) {
+            Min = Vector3<float>(std::min(Min.X, point.X), std::min(Min.Y, point.Y), std::min(Min.Z, point.Z));
+            Max = Vector3<float>(std::max(Max.X, point.X), std::max(Max.Y, point.Y), std::max(Max.Z, point.Z));
+        }
+
+        void    Grow(AABB const& box) {
+            Min = Vector3<float>(std::min(Min.X, box.Min.X), std::min(Min.Y, box.Min.Y), std::min(Min.Z, box.Min.Z));
+            Max = Vector3<float>(std::max(Max.X, box.Max.X), std::max(Max.Y, box.Max.Y), std::max(Max.Z, box.Max.Z));
+        }
+
+        // Shrinks to the intersection with box, which may leave it empty
+        void    Clip(AABB const& box) {
+            Min = Vector3<float>(std::max(Min.X, box.Min.X), std::max(Min.Y, box.Min.Y), std::max(Min.Z, box.Min.Z));
+            Max = Vector3<float>(std::min(Max.X, box.Max.X), std::min(Max.Y, box.Max.Y), std::min(Max.Z, box.Max.Z));
+        }
+
+        bool    IsEmpty() const {
+            return Min.X > Max.X || Min.Y > Max.Y || Min.Z > Max.Z;
+        }
+
+        bool    Contains(Vector3<float> const& point) const {
+            return point.X >= Min.X && point.X <= Max.X && point.Y >= Min.Y && point.Y <= Max.Y
+                && point.Z >= Min.Z && point.Z <= Max.Z;
+        }
+
+        // Distance from point to the nearest point of the box, 0 inside
+        float   Distance(Vector3<float> const& point) const {
+            float const dx = std::max(std::max(Min.X - point.X, point.X - Max.X), 0.f);
+            float const dy = std::max(std::max(Min.Y - point.Y, point.Y - Max.Y), 0.f);
+            float const dz = std::max(std::max(Min.Z - point.Z, point.Z - Max.Z), 0.f);
+            return std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+
+        Vector3<float>  Centroid() const {
+            return (Min + Max) * 0.5f;
+        }
+
+        Vector3<float>  Extent() const {
+            return Max - Min;
+        }
+
+        float   Area() const {
+            if (IsEmpty()) {
+                return 0.f;
+            }
+            Vector3<float> const e = Extent();
+            return 2.f * (e.X * e.Y + e.Y * e.Z + e.Z * e.X);
+        }
+
+        float   Volume() const {
+            if (IsEmpty()) {
+                return 0.f;
+            }
+            Vector3<float> const e = Extent();
+            return e.X * e.Y * e.Z;
+        }
+
+        // Entry distance of the ray into the box within [0, tMax], infinity on a miss
+        float   Hit(Vector3<float> const& origin, Vector3<float> const& inverseDir, float tMax) const {
+            float const tx1 = (Min.X - origin.X) * inverseDir.X;
+            float const tx2 = (Max.X - origin.X) * inverseDir.X;
+            float const ty1 = (Min.Y - origin.Y) * inverseDir.Y;
+            float const ty2 = (Max.Y - origin.Y) * inverseDir.Y;
+            float const tz1 = (Min.Z - origin.Z) * inverseDir.Z;
+            float const tz2 = (Max.Z - origin.Z) * inverseDir.Z;
+            float const tNear = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), 0.f));
+            float const tFar = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), tMax));
+            return tNear <= tFar ? tNear : std::numeric_limits<float>::infinity();
+        }
+    };
+}  // namespace rt
@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <numeric>
+#include <string>
+#include "BVH.h"
+
+namespace rt {
+    namespace {
+        struct RangeBounds {
+            AABB    Bounds;
+            AABB    Centroids;
+        };
+
+        struct Bin {
+            AABB            Bounds;
+            std::uint32_t   Count = 0;
+        };
+
+        using Bins = std::array<std::array<Bin, BVH::BinCount>, 3>;
+
+        constexpr std::size_t ParallelGrain = 1024;
+
+        // State shared by both builders. Nodes are preallocated for the worst case and
+        // handed out in sibling pairs, so subtrees can be built concurrently.
+        struct BuildContext {
+            BuildContext(std::vector<AABB> const& boxes, LargeArray<BVHNode>& nodes, std::vector<std::uint32_t>& indices,
+                         ThreadPool& pool) : Boxes(boxes), Nodes(nodes), Indices(indices), Pool(pool), NodeCount(1) {
+                Centroids.resize(boxes.size());
+                pool.ParallelFor(boxes.size(), ParallelGrain, [this](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        Centroids[i] = Boxes[i].Centroid();
+                    }
+                });
+            }
+
+            std::uint32_t   AllocatePair() {
+                return NodeCount.fetch_add(2, std::memory_order_relaxed);
+            }
+
+            // Splits [begin, end) into chunks, in parallel for large ranges, and returns one partial result per chunk
+            template <class T, class Body>
+            std::vector<T>  Reduce(std::uint32_t begin, std::uint32_t end, Body const& body) {
+                std::size_t const count = end - begin;
+                std::size_t const chunks = count < BVH::ParallelThreshold ? 1
+                    : std::min<std::size_t>(Pool.GetThreadCount() * 4, count / ParallelGrain + 1);
+                std::vector<T> partials(chunks);
+                if (chunks == 1) {
+                    body(begin, end, partials[0]);
+                    return partials;
+                }
+                Pool.ParallelFor(chunks, 1, [&](std::size_t first, std::size_t last) {
+                    for (std::size_t chunk = first; chunk < last; ++chunk) {
+                        body(static_cast<std::uint32_t>(begin + count * chunk / chunks),
+                             static_cast<std::uint32_t>(begin + count * (chunk + 1) / chunks), partials[chunk]);
+                    }
+                });
+                return partials;
+            }
+
+            RangeBounds     Measure(std::uint32_t begin, std::uint32_t end) {
+                auto partials = Reduce<RangeBounds>(begin, end, [this](std::uint32_t first, std::uint32_t last, RangeBounds& partial) {
+                    for (std::uint32_t i = first; i < last; ++i) {
+                        partial.Bounds.Grow(Boxes[Indices[i]]);
+                        partial.Centroids.Grow(Centroids[Indices[i]]);
+                    }
+                });
+                RangeBounds total;
+                for (auto const& partial : partials) {
+                    total.Bounds.Grow(partial.Bounds);
+                    total.Centroids.Grow(partial.Centroids);
+                }
+                return total;
+            }
+
+            std::vector<AABB> const&        Boxes;
+            std::vector<Vector3<float>>     Centroids;
+            LargeArray<BVHNode>&            Nodes;
+            std::vector<std::uint32_t>&     Indices;
+            ThreadPool&                     Pool;
+            std::atomic<std::uint32_t>      NodeCount;
+        };
+
+        // Top-down build choosing each split among BinCount centroid bins per axis by
+        // surface area heuristic. Large subtrees become tasks, large ranges are binned in parallel.
+        struct SAHBuilder : BuildContext {
+            using BuildContext::BuildContext;
+
+            void    Build(std::uint32_t nodeIndex, std::uint32_t begin, std::uint32_t end, unsigned int depth, TaskGroup& group) {
+                RangeBounds const range = Measure(begin, end);
+                BVHNode& node = Nodes[nodeIndex];
+                node.Bounds = range.Bounds;
+                std::uint32_t const count = end - begin;
+                if (count == 1 || depth + 1 >= BVH::MaxDepth) {
+                    node.Offset = begin;
+                    node.Count = count;
+                    return;
+                }
+
+                std::uint32_t mid = begin + count / 2;
+                int axis = -1;
+                std::uint32_t split = 0;
+                if (range.Centroids.Extent().X > 0.f || range.Centroids.Extent().Y > 0.f || range.Centroids.Extent().Z > 0.f) {
+                    float const cost = _findSplit(begin, end, range, axis, split);
+                    // Leaf cost is one intersection per primitive, a split adds one traversal step
+                    float const area = range.Bounds.Area();
+                    float const splitCost = area > 0.f ? 1.f + cost / area : static_cast<float>(count);
+                    if (count <= BVH::MaxLeafSize && splitCost >= count) {
+                        node.Offset = begin;
+                        node.Count = count;
+                        return;
+                    }
+                    if (axis >= 0) {
+                        float const minimum = Component(range.Centroids.Min, axis);
+                        float const scale = BVH::BinCount / Component(range.Centroids.Extent(), axis);
+                        auto const first = Indices.begin() + begin;
+                        auto const last = Indices.begin() + end;
+                        mid = begin + static_cast<std::uint32_t>(std::partition(first, last, [&](std::uint32_t index) {
+                            return _binOf(Component(Centroids[index], axis), minimum, scale) < split;
+                        }) - first);
+                        if (mid == begin || mid == end) {
+                            mid = begin + count / 2;
+                        }
+                    }
+                } else if (count <= BVH::MaxLeafSize) {
+                    node.Offset = begin;
+                    node.Count = count;
+                    return;
+                }
+
+                std::uint32_t const children = AllocatePair();
+                node.Offset = children;
+                node.Count = 0;
+                if (count >= BVH::ParallelThreshold) {
+                    group.Run([this, children, begin, mid, depth, &group]() { Build(children, begin, mid, depth + 1, group); });
+                } else {
+                    Build(children, begin, mid, depth + 1, group);
+                }
+                Build(children + 1, mid, end, depth + 1, group);
+            }
+
+        private:
+            static std::uint32_t _binOf(float centroid, float minimum, float scale) {
+                return std::min(static_cast<std::uint32_t>((centroid - minimum) * scale), BVH::BinCount - 1);
+            }
+
+            // Returns the lowest unnormalized SAH cost and sets axis and split bin, axis stays -1 if no split separates anything
+            float   _findSplit(std::uint32_t begin, std::uint32_t end, RangeBounds const& range, int& axis, std::uint32_t& split) {
+                Vector3<float> const extent = range.Centroids.Extent();
+                auto partials = Reduce<Bins>(begin, end, [&](std::uint32_t first, std::uint32_t last, Bins& bins) {
+                    for (std::uint32_t i = first; i < last; ++i) {
+                        std::uint32_t const index = Indices[i];
+                        for (int a = 0; a < 3; ++a) {
+                            if (Component(extent, a) <= 0.f) {
+                                continue;
+                            }
+                            Bin& bin = bins[a][_binOf(Component(Centroids[index], a), Component(range.Centroids.Min, a),
+                                                      BVH::BinCount / Component(extent, a))];
+                            bin.Bounds.Grow(Boxes[index]);
+                            ++bin.Count;
+                        }
+                    }
+                });
+                Bins bins = partials[0];
+                for (std::size_t p = 1; p < partials.size(); ++p) {
+                    for (int a = 0; a < 3; ++a) {
+                        for (unsigned int b = 0; b < BVH::BinCount; ++b) {
+                            bins[a][b].Bounds.Grow(partials[p][a][b].Bounds);
+                            bins[a][b].Count += partials[p][a][b].Count;
+                        }
+                    }
+                }
+
+                float best = std::numeric_limits<float>::max();
+                for (int a = 0; a < 3; ++a) {
+                    // Sweep from the right to get the cost of every right side, then from the left
+                    std::array<float, BVH::BinCount> rightCost{};
+                    AABB box;
+                    std::uint32_t count = 0;
+                    for (unsigned int b = BVH::BinCount - 1; b > 0; --b) {
+                        box.Grow(bins[a][b].Bounds);
+                        count += bins[a][b].Count;
+                        rightCost[b] = count > 0 ? box.Area() * count : -1.f;
+                    }
+                    box = AABB();
+                    count = 0;
+                    for (unsigned int b = 1; b < BVH::BinCount; ++b) {
+                        box.Grow(bins[a][b - 1].Bounds);
+                        count += bins[a][b - 1].Count;
+                        if (count == 0 || rightCost[b] < 0.f) {
+                            continue;
+                        }
+                        float const cost = box.Area() * count + rightCost[b];
+                        if (cost < best) {
+                            best = cost;
+                            axis = a;
+                            split = b;
+                        }
+                    }
+                }
+                return best;
+            }
+        };
+
+        // Sorts primitives along a 30-bit Morton curve of their centroids and splits
+        // ranges at the highest differing code bit. Much faster than SAH, lower quality.
+        struct LBVHBuilder : BuildContext {
+            using BuildContext::BuildContext;
+
+            void    Sort(AABB const& centroidBounds) {
+                std::size_t const count = Indices.size();
+                Codes.resize(count);
+                Vector3<float> const extent = centroidBounds.Extent();
+                Vector3<float> const scale(extent.X > 0.f ? 1023.f / extent.X : 0.f, extent.Y > 0.f ? 1023.f / extent.Y : 0.f,
+                                           extent.Z > 0.f ? 1023.f / extent.Z : 0.f);
+                Pool.ParallelFor(count, ParallelGrain, [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        Vector3<float> const offset = Centroids[i] - centroidBounds.Min;
+                        Codes[i] = (_expandBits(static_cast<std::uint32_t>(offset.X * scale.X)) << 2)
+                                 | (_expandBits(static_cast<std::uint32_t>(offset.Y * scale.Y)) << 1)
+                                 | _expandBits(static_cast<std::uint32_t>(offset.Z * scale.Z));
+                    }
+                });
+                _radixSort();
+            }
+
+            AABB    Build(std::uint32_t nodeIndex, std::uint32_t begin, std::uint32_t end, unsigned int depth) {
+                BVHNode& node = Nodes[nodeIndex];
+                std::uint32_t const count = end - begin;
+                if (count <= BVH::MaxLeafSize || depth + 1 >= BVH::MaxDepth) {
+                    node.Offset = begin;
+                    node.Count = count;
+                    for (std::uint32_t i = begin; i < end; ++i) {
+                        node.Bounds.Grow(Boxes[Indices[i]]);
+                    }
+                    return node.Bounds;
+                }
+
+                std::uint32_t mid = begin + count / 2;
+                std::uint32_t const difference = Codes[begin] ^ Codes[end - 1];
+                if (difference != 0) {
+                    // Codes share every bit above the highest differing one, so one binary search finds the split
+                    std::uint32_t bit = 1u << 31;
+                    while ((difference & bit) == 0) {
+                        bit >>= 1;
+                    }
+                    mid = static_cast<std::uint32_t>(std::partition_point(Codes.begin() + begin, Codes.begin() + end,
+                        [bit](std::uint32_t code) { return (code & bit) == 0; }) - Codes.begin());
+                }
+
+                std::uint32_t const children = AllocatePair();
+                node.Offset = children;
+                node.Count = 0;
+                AABB left;
+                AABB right;
+                if (count >= BVH::ParallelThreshold) {
+                    TaskGroup group(Pool);
+                    group.Run([&]() { left = Build(children, begin, mid, depth + 1); });
+                    right = Build(children + 1, mid, end, depth + 1);
+                    group.Wait();
+                } else {
+                    left = Build(children, begin, mid, depth + 1);
+                    right = Build(children + 1, mid, end, depth + 1);
+                }
+                node.Bounds = left;
+                node.Bounds.Grow(right);
+                return node.Bounds;
+            }
+
+            std::vector<std::uint32_t>  Codes;
+
+        private:
+            static std::uint32_t _expandBits(std::uint32_t v) {
+                v = (v * 0x00010001u) & 0xFF0000FFu;
+                v = (v * 0x00000101u) & 0x0F00F00Fu;
+                v = (v * 0x00000011u) & 0xC30C30C3u;
+                v = (v * 0x00000005u) & 0x49249249u;
+                return v;
+            }
+
+            // Stable LSD radix sort of (code, index) pairs, 8 bits per pass. Each chunk
+            // histograms its digits in parallel, then scatters to its own prefix offsets.
+            void    _radixSort() {
+                std::size_t const count = Codes.size();
+                std::size_t const chunks = count < BVH::ParallelThreshold ? 1
+                    : std::min<std::size_t>(Pool.GetThreadCount() * 4, count / ParallelGrain + 1);
+                std::vector<std::uint32_t> codes(count);
+                std::vector<std::uint32_t> indices(count);
+                std::vector<std::array<std::uint32_t, 256>> offsets(chunks);
+                auto chunkBegin = [&](std::size_t chunk) { return count * chunk / chunks; };
+                for (unsigned int shift = 0; shift < 32; shift += 8) {
+                    Pool.ParallelFor(chunks, 1, [&](std::size_t first, std::size_t last) {
+                        for (std::size_t chunk = first; chunk < last; ++chunk) {
+                            offsets[chunk].fill(0);
+                            for (std::size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i) {
+                                ++offsets[chunk][(Codes[i] >> shift) & 0xFF];
+                            }
+                        }
+                    });
+                    std::uint32_t position = 0;
+                    for (unsigned int digit = 0; digit < 256; ++digit) {
+                        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                            std::uint32_t const size = offsets[chunk][digit];
+                            offsets[chunk][digit] = position;
+                            position += size;
+                        }
+                    }
+                    Pool.ParallelFor(chunks, 1, [&](std::size_t first, std::size_t last) {
+                        for (std::size_t chunk = first; chunk < last; ++chunk) {
+                            for (std::size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i) {
+                                std::uint32_t const target = offsets[chunk][(Codes[i] >> shift) & 0xFF]++;
+                                codes[target] = Codes[i];
+                                indices[target] = Indices[i];
+                            }
+                        }
+                    });
+                    Codes.swap(codes);
+                    Indices.swap(indices);
+                }
+            }
+        };
+    }
+
+    void BVH::Build(std::vector<AABB> const& primitives, BVHBuilder builder, ThreadPool& pool) {
+        auto const start = std::chrono::steady_clock::now();
+        std::uint32_t const count = static_cast<std::uint32_t>(primitives.size());
+        _indices.resize(count);
+        std::iota(_indices.begin(), _indices.end(), 0u);
+        _nodes.assign(count > 0 ? 2 * count - 1 : 0, BVHNode());
+        std::uint32_t nodeCount = 0;
+        if (count > 0 && builder == BVHBuilder::BinnedSAH) {
+            SAHBuilder sah(primitives, _nodes, _indices, pool);
+            TaskGroup group(pool);
+            sah.Build(0, 0, count, 0, group);
+            group.Wait();
+            nodeCount = sah.NodeCount;
+        } else if (count > 0) {
+            LBVHBuilder lbvh(primitives, _nodes, _indices, pool);
+            lbvh.Sort(lbvh.Measure(0, count).Centroids);
+            lbvh.Build(0, 0, count, 0);
+            nodeCount = lbvh.NodeCount;
+        }
+        _nodes.resize(nodeCount);
+        _nodes.shrink_to_fit();
+
+        _stats = BVHStats();
+        _stats.Builder = builder;
+        _stats.Primitives = count;
+        _stats.References = count;
+        _stats.BuildTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        _computeStats();
+    }
+
+    LargeArray<BVHNode> const& BVH::GetNodes() const {
+        return _nodes;
+    }
+
+    std::vector<std::uint32_t> const& BVH::GetIndices() const {
+        return _indices;
+    }
+
+    BVHStats const& BVH::GetStats() const {
+        return _stats;
+    }
+
+    void BVH::ReleaseNodes() {
+        LargeArray<BVHNode>().swap(_nodes);
+    }
+
+    void BVH::Cull(Frustum const& frustum, std::vector<TraversalRoot>& roots) const {
+        roots.clear();
+        if (_nodes.empty() || !frustum.Overlaps(_nodes[0].Bounds)) {
+            return;
+        }
+        roots.push_back(TraversalRoot{_nodes[0].Bounds, 0, _nodes[0].Count});
+        ExpandRoots(roots, MaxRoots, [&](TraversalRoot const& root, TraversalRoot* children) {
+            std::size_t count = 0;
+            for (std::uint32_t child = _nodes[root.Index].Offset; child < _nodes[root.Index].Offset + 2; ++child) {
+                if (frustum.Overlaps(_nodes[child].Bounds)) {
+                    children[count++] = TraversalRoot{_nodes[child].Bounds, child, _nodes[child].Count};
+                }
+            }
+            return count;
+        });
+    }
+
+    void BVH::_computeStats() {
+        if (_nodes.empty()) {
+            return;
+        }
+        // SAH cost with unit traversal and intersection costs, relative to the root's area
+        float const rootArea = _nodes[0].Bounds.Area();
+        float cost = 0.f;
+        double interiorVolume = 0.0;
+        double emptyVolume = 0.0;
+        std::vector<std::pair<std::uint32_t, std::size_t>> stack{{0, 1}};
+        while (!stack.empty()) {
+            auto const [index, depth] = stack.back();
+            stack.pop_back();
+            BVHNode const& node = _nodes[index];
+            float const relativeArea = rootArea > 0.f ? node.Bounds.Area() / rootArea : 1.f;
+            _stats.MaxDepth = std::max(_stats.MaxDepth, depth);
+            ++_stats.Nodes;
+            if (node.IsLeaf()) {
+                ++_stats.Leaves;
+                cost += relativeArea * node.Count;
+                if (_stats.LeafDepths.size() <= depth) {
+                    _stats.LeafDepths.resize(depth + 1);
+                }
+                ++_stats.LeafDepths[depth];
+                if (_stats.LeafSizes.size() <= node.Count) {
+                    _stats.LeafSizes.resize(node.Count + 1);
+                }
+                ++_stats.LeafSizes[node.Count];
+            } else {
+                cost += relativeArea;
+                // Children may overlap, so the covered part is their union
+                AABB const& left = _nodes[node.Offset].Bounds;
+                AABB const& right = _nodes[node.Offset + 1].Bounds;
+                AABB overlap = left;
+                overlap.Clip(right);
+                double const covered = double(left.Volume()) + right.Volume() - overlap.Volume();
+                interiorVolume += node.Bounds.Volume();
+                emptyVolume += std::max(0.0, node.Bounds.Volume() - covered);
+                stack.emplace_back(node.Offset, depth + 1);
+                stack.emplace_back(node.Offset + 1, depth + 1);
+            }
+        }
+        _stats.SAHCost = cost;
+        _stats.EmptySpace = interiorVolume > 0.0 ? static_cast<float>(emptyVolume / interiorVolume) : 0.f;
+    }
+
+    char const* BVH::GetName(BVHBuilder builder) {
+        switch (builder) {
+            case BVHBuilder::BinnedSAH:
+                return "binned SAH";
+            case BVHBuilder::LBVH:
+                return "LBVH";
+            case BVHBuilder::SBVH:
+                return "SBVH";
+        }
+        return "unknown";
+    }
+
+    void BVH::Report(BVHStats const& stats, std::ostream& out) {
+        out << std::fixed << std::setprecision(2)
+            << "BVH (" << GetName(stats.Builder) << "): " << stats.Primitives << " triangles, ";
+        if (stats.References != stats.Primitives && stats.Primitives > 0) {
+            out << stats.References << " references (+"
+                << 100.f * (stats.References - stats.Primitives) / stats.Primitives << "%), ";
+        }
+        out << stats.Nodes << " nodes, "
+            << stats.Leaves << " leaves, depth " << stats.MaxDepth << ", SAH cost " << stats.SAHCost
+            << ", built in " << stats.BuildTime << " ms" << std::endl;
+    }
+
+    void BVH::ReportQuality(BVHStats const& stats, std::ostream& out) {
+        // One bar per bucket, scaled to the largest one
+        auto histogram = [&out](char const* label, std::vector<std::size_t> const& counts, std::size_t total) {
+            std::size_t const largest = counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+            out << label << std::endl;
+            for (std::size_t bucket = 0; bucket < counts.size(); ++bucket) {
+                if (counts[bucket] == 0) {
+                    continue;
+                }
+                std::size_t const width = (counts[bucket] * HistogramWidth + largest - 1) / largest;
+                out << std::setw(6) << bucket << " " << std::setw(9) << counts[bucket] << " "
+                    << std::setw(6) << 100.f * counts[bucket] / total << "% " << std::string(width, '#') << std::endl;
+            }
+        };
+        out << std::fixed << std::setprecision(2)
+            << "Quality: SAH cost " << stats.SAHCost << ", "
+            << (stats.Leaves > 0 ? static_cast<float>(stats.References) / stats.Leaves : 0.f) << " triangles per leaf, "
+            << 100.f * stats.EmptySpace << "% empty space in interior nodes" << std::endl;
+        histogram("  Leaf depth:", stats.LeafDepths, stats.Leaves);
+        histogram("  Leaf size:", stats.LeafSizes, stats.Leaves);
+    }
+}  // namespace rt
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <vector>
+#include "../Engine/Memory.h"
+#include "../Engine/Tools.h"
+#include "../Render/ThreadPool.h"
+#include "AABB.h"
+#include "Frustum.h"
+
+namespace rt {
+    enum class BVHBuilder {
+        BinnedSAH,
+        LBVH,
+        // Binned SAH that may also split triangle references at spatial planes
+        SBVH
+    };
+
+    struct AccelOptions {
+        BVHBuilder      Builder = BVHBuilder::BinnedSAH;
+        // Children per node: 2 traverses the binary BVH, 4 or 8 a collapsed quantized one
+        unsigned int    Width = 4;
+        // SBVH only: extra triangle references allowed, as a fraction of the triangle count
+        float           SpatialOverhead = 0.3f;
+        // Threads building the hierarchies, 0 for one per hardware thread
+        unsigned int    BuildThreads = 0;
+    };
+
+    using TriangleVertices = std::array<Vector3<float>, 3>;
+
+    // Interior nodes store their children as a pair at Offset and Offset + 1,
+    // leaves store Count primitives starting at Offset in leaf order.
+    struct BVHNode {
+        AABB            Bounds;
+        std::uint32_t   Offset = 0;
+        std::uint32_t   Count = 0;
+
+        bool    IsLeaf() const {
+            return Count > 0;
+        }
+    };
+
+    struct BVHStats {
+        BVHBuilder      Builder = BVHBuilder::BinnedSAH;
+        std::size_t     Primitives = 0;
+        // Leaf slots, more than Primitives when spatial splits duplicated references
+        std::size_t     References = 0;
+        std::size_t     Nodes = 0;
+        std::size_t     Leaves = 0;
+        std::size_t     MaxDepth = 0;
+        float           BuildTime = 0.f;
+        float           SAHCost = 0.f;
+        // Leaves at each depth, the root being depth 1, and leaves holding each primitive count
+        std::vector<std::size_t>    LeafDepths;
+        std::vector<std::size_t>    LeafSizes;
+        // Fraction of the interior nodes' volume that neither child covers
+        float           EmptySpace = 0.f;
+    };
+
+    // Work done by traversals: nodes whose children or primitives were tested, and primitive tests
+    struct TraversalCost {
+        std::uint32_t   Nodes = 0;
+        std::uint32_t   Triangles = 0;
+
+        TraversalCost&  operator+=(TraversalCost const& other) {
+            Nodes += other.Nodes;
+            Triangles += other.Triangles;
+            return *this;
+        }
+    };
+
+    // Subtree a traversal may start from instead of the root, Count leaf slots from Index when
+    // Count is above 0 and otherwise the node Index of the hierarchy that produced it
+    struct TraversalRoot {
+        AABB            Bounds;
+        std::uint32_t   Index = 0;
+        std::uint32_t   Count = 0;
+    };
+
+    // Opens the roots breadth first, replacing each interior one by the children children(root, out)
+    // writes to out and counts, as long as the list stays within maxRoots
+    template <class Children>
+    void ExpandRoots(std::vector<TraversalRoot>& roots, std::size_t maxRoots, Children&& children) {
+        // Enough for the widest nodes
+        TraversalRoot opened[8];
+        std::size_t i = 0;
+        while (i < roots.size()) {
+            if (roots[i].Count > 0) {
+                ++i;
+                continue;
+            }
+            std::size_t const count = children(roots[i], opened);
+            if (roots.size() - 1 + count > maxRoots) {
+                ++i;
+                continue;
+            }
+            roots.erase(roots.begin() + static_cast<std::ptrdiff_t>(i));
+            roots.insert(roots.end(), opened, opened + count);
+        }
+    }
+
+    // Binary bounding volume hierarchy over a set of primitive boxes, built in parallel
+    // either top-down with binned SAH or from Morton-sorted centroids (LBVH). The SBVH
+    // build works on triangles instead, so a primitive may occupy several leaf slots.
+    class BVH {
+    public:
+        void    Build(std::vector<AABB> const& primitives, BVHBuilder builder, ThreadPool& pool);
+        // SBVH build over triangles, duplicating at most maxOverhead * triangles.size() references
+        void    BuildSpatial(std::vector<TriangleVertices> const& triangles, float maxOverhead, ThreadPool& pool);
+
+        LargeArray<BVHNode> const&          GetNodes() const;
+        // Primitive index for each leaf slot, GetStats().References of them
+        std::vector<std::uint32_t> const&   GetIndices() const;
+        BVHStats const&                     GetStats() const;
+        // Frees the nodes once another structure has been built from them, keeping indices and stats
+        void                                ReleaseNodes();
+
+        // Calls visit(slot, tMax) for every leaf slot whose node the ray enters before tMax.
+        // visit may shorten tMax and returns true to stop the traversal.
+        template <class Visit>
+        void    Traverse(Ray const& ray, float tMax, Visit&& visit) const {
+            _traverse<false>(ray, tMax, visit, nullptr);
+        }
+        // Same, adding the nodes entered and the slots visited to cost
+        template <class Visit>
+        void    Traverse(Ray const& ray, float tMax, Visit&& visit, TraversalCost& cost) const {
+            _traverse<true>(ray, tMax, visit, &cost);
+        }
+        // Starts from roots, which Cull made for a frustum holding the ray, instead of the root
+        template <class Visit>
+        void    TraverseFrom(std::vector<TraversalRoot> const& roots, Ray const& ray, float tMax, Visit&& visit) const {
+            _traverse<false>(ray, tMax, visit, nullptr, &roots);
+        }
+        template <class Visit>
+        void    TraverseFrom(std::vector<TraversalRoot> const& roots, Ray const& ray, float tMax, Visit&& visit, TraversalCost& cost) const {
+            _traverse<true>(ray, tMax, visit, &cost, &roots);
+        }
+        // The subtrees overlapping the frustum, opened from the root while at most MaxRoots remain.
+        // Empty when nothing does.
+        void    Cull(Frustum const& frustum, std::vector<TraversalRoot>& roots) const;
+
+        // Calls visit(slot) for every leaf slot whose node contains point
+        template <class Visit>
+        void    Query(Vector3<float> const& point, Visit&& visit) const;
+
+        static char const*  GetName(BVHBuilder builder);
+        static void         Report(BVHStats const& stats, std::ostream& out);
+        // Depth and leaf size histograms and empty space
+        static void         ReportQuality(BVHStats const& stats, std::ostream& out);
+
+        static constexpr unsigned int   BinCount = 16;
+        static constexpr unsigned int   MaxLeafSize = 4;
+        static constexpr unsigned int   MaxDepth = 64;
+        static constexpr unsigned int   MaxRoots = 32;
+        static constexpr std::size_t    ParallelThreshold = 4096;
+        static constexpr std::size_t    HistogramWidth = 40;
+        // Spatial splits are only tried where object split children overlap by this fraction of the root area
+        static constexpr float          SpatialAlpha = 1e-5f;
+
+    private:
+        LargeArray<BVHNode>         _nodes;
+        std::vector<std::uint32_t>  _indices;
+        BVHStats                    _stats;
+
+        void    _computeStats();
+        template <bool Counted, class Visit>
+        void    _traverse(Ray const& ray, float tMax, Visit& visit, TraversalCost* cost,
+                          std::vector<TraversalRoot> const* roots = nullptr) const;
+    };
+
+    template <bool Counted, class Visit>
+    void BVH::_traverse(Ray const& ray, float tMax, Visit& visit, TraversalCost* cost, std::vector<TraversalRoot> const* roots) const {
+        if (_nodes.empty()) {
+            return;
+        }
+        Vector3<float> const inverseDir = InverseDirection(ray.Direction);
+        std::uint32_t stack[MaxDepth + MaxRoots];
+        float stackNear[MaxDepth + MaxRoots];
+        unsigned int top = 0;
+        std::uint32_t current = 0;
+        if (roots == nullptr) {
+            if (_nodes[0].Bounds.Hit(ray.Origin, inverseDir, tMax) == std::numeric_limits<float>::infinity()) {
+                return;
+            }
+        } else {
+            // Stack the roots the ray enters far to near and start from the nearest
+            for (TraversalRoot const& root : *roots) {
+                float const near = root.Bounds.Hit(ray.Origin, inverseDir, tMax);
+                if (near == std::numeric_limits<float>::infinity()) {
+                    continue;
+                }
+                unsigned int position = top++;
+                while (position > 0 && stackNear[position - 1] < near) {
+                    stack[position] = stack[position - 1];
+                    stackNear[position] = stackNear[position - 1];
+                    --position;
+                }
+                stack[position] = root.Index;
+                stackNear[position] = near;
+            }
+            if (top == 0) {
+                return;
+            }
+            current = stack[--top];
+        }
+        while (true) {
+            BVHNode const& node = _nodes[current];
+            if constexpr (Counted) {
+                ++cost->Nodes;
+            }
+            if (node.IsLeaf()) {
+                for (std::uint32_t slot = node.Offset; slot < node.Offset + node.Count; ++slot) {
+                    if constexpr (Counted) {
+                        ++cost->Triangles;
+                    }
+                    if (visit(slot, tMax)) {
+                        return;
+                    }
+                }
+            } else {
+                // Descend into the nearer child first so tMax shrinks early
+                float const nearLeft = _nodes[node.Offset].Bounds.Hit(ray.Origin, inverseDir, tMax);
+                float const nearRight = _nodes[node.Offset + 1].Bounds.Hit(ray.Origin, inverseDir, tMax);
+                bool const hitLeft = nearLeft != std::numeric_limits<float>::infinity();
+                bool const hitRight = nearRight != std::numeric_limits<float>::infinity();
+                if (hitLeft && hitRight) {
+                    bool const leftFirst = nearLeft <= nearRight;
+                    stackNear[top] = leftFirst ? nearRight : nearLeft;
+                    stack[top++] = leftFirst ? node.Offset + 1 : node.Offset;
+                    current = leftFirst ? node.Offset : node.Offset + 1;
+                    continue;
+                }
+                if (hitLeft || hitRight) {
+                    current = hitLeft ? node.Offset : node.Offset + 1;
+                    continue;
+                }
+            }
+            // Skip deferred nodes that now start beyond the closest hit
+            do {
+                if (top == 0) {
+                    return;
+                }
+                current = stack[--top];
+            } while (stackNear[top] > tMax);
+        }
+    }
+
+    template <class Visit>
+    void BVH::Query(Vector3<float> const& point, Visit&& visit) const {
+        if (_nodes.empty() || !_nodes[0].Bounds.Contains(point)) {
+            return;
+        }
+        std::uint32_t stack[MaxDepth];
+        unsigned int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            BVHNode const& node = _nodes[stack[--top]];
+            if (node.IsLeaf()) {
+                for (std::uint32_t slot = node.Offset; slot < node.Offset + node.Count; ++slot) {
+                    visit(slot);
+                }
+                continue;
+            }
+            for (std::uint32_t child = node.Offset; child < node.Offset + 2; ++child) {
+                if (_nodes[child].Bounds.Contains(point)) {
+                    stack[top++] = child;
+                }
+            }
+        }
+    }
+}  // namespace rt
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include "AABB.h"
+
+namespace rt {
+    // Four planes through Apex bounding a bundle of rays leaving it. No ray of the bundle can
+    // enter a box lying wholly behind one of the planes.
+    struct Frustum {
+        Vector3<float>  Apex;
+        // Unit normals pointing into the frustum
+        Vector3<float>  Normals[4];
+
+        // Fits the planes around count directions, direction(i) returning the i-th. Fails when
+        // the directions spread too far for a frustum around their mean to hold them.
+        template <class Direction>
+        bool    Enclose(Vector3<float> const& apex, std::size_t count, Direction&& direction) {
+            Vector3<float> axis;
+            for (std::size_t i = 0; i < count; ++i) {
+                axis = axis + direction(i);
+            }
+            if (count == 0 || axis.Norm() == 0.f) {
+                return false;
+            }
+            axis.Normalize();
+            Vector3<float> u = axis.Cross(std::fabs(axis.X) < 0.9f ? Vector3<float>(1.f, 0.f, 0.f) : Vector3<float>(0.f, 1.f, 0.f));
+            u.Normalize();
+            Vector3<float> const v = axis.Cross(u);
+            // Bounds of the directions projected onto the plane one unit along the axis
+            float minX = std::numeric_limits<float>::max();
+            float maxX = -std::numeric_limits<float>::max();
+            float minY = std::numeric_limits<float>::max();
+            float maxY = -std::numeric_limits<float>::max();
+            for (std::size_t i = 0; i < count; ++i) {
+                Vector3<float> const d = direction(i);
+                float const w = d.Dot(axis);
+                if (w < MinCosine * d.Norm()) {
+                    return false;
+                }
+                minX = std::min(minX, d.Dot(u) / w);
+                maxX = std::max(maxX, d.Dot(u) / w);
+                minY = std::min(minY, d.Dot(v) / w);
+                maxY = std::max(maxY, d.Dot(v) / w);
+            }
+            Apex = apex;
+            Normals[0] = u - axis * minX;
+            Normals[1] = axis * maxX - u;
+            Normals[2] = v - axis * minY;
+            Normals[3] = axis * maxY - v;
+            for (Vector3<float>& normal : Normals) {
+                normal.Normalize();
+            }
+            return true;
+        }
+
+        // Tests the box corner farthest along each normal. Corners within Slack of a plane, relative
+        // to their distance from the apex, still count as inside, so rounding never culls a box a ray hits.
+        bool    Overlaps(AABB const& box) const {
+            for (Vector3<float> const& normal : Normals) {
+                Vector3<float> const corner(normal.X >= 0.f ? box.Max.X : box.Min.X,
+                                            normal.Y >= 0.f ? box.Max.Y : box.Min.Y,
+                                            normal.Z >= 0.f ? box.Max.Z : box.Min.Z);
+                Vector3<float> const offset = corner - Apex;
+                if (normal.Dot(offset) < -Slack * offset.Norm()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Directions must stay within about 84 degrees of their mean
+        static constexpr float  MinCosine = 0.1f;
+        static constexpr float  Slack = 1e-4f;
+    };
+}  // namespace rt
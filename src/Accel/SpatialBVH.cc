@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include "BVH.h"
+
+namespace rt {
+    namespace {
+        // A triangle, or the part of it inside Bounds once spatial splits have clipped it
+        struct Reference {
+            AABB            Bounds;
+            std::uint32_t   Primitive = 0;
+        };
+
+        struct ObjectBin {
+            AABB            Bounds;
+            std::uint32_t   Count = 0;
+        };
+
+        // References are counted in the bin where they start and the bin where they end
+        struct SpatialBin {
+            AABB            Bounds;
+            std::uint32_t   Entries = 0;
+            std::uint32_t   Exits = 0;
+        };
+
+        using ObjectBins = std::array<std::array<ObjectBin, BVH::BinCount>, 3>;
+        using SpatialBins = std::array<std::array<SpatialBin, BVH::BinCount>, 3>;
+
+        struct Split {
+            float           Cost = std::numeric_limits<float>::max();
+            int             Axis = -1;
+            std::uint32_t   Bin = 0;
+            AABB            Left;
+            AABB            Right;
+        };
+
+        constexpr std::size_t ParallelGrain = 1024;
+
+        std::uint32_t binOf(float value, float minimum, float scale) {
+            return std::min(static_cast<std::uint32_t>(std::max((value - minimum) * scale, 0.f)), BVH::BinCount - 1);
+        }
+
+        // Bounds of the parts of the triangle on each side of the plane, clipped to the reference
+        void splitReference(TriangleVertices const& triangle, Reference const& reference, int axis, float position,
+                            Reference& left, Reference& right) {
+            left = Reference();
+            right = Reference();
+            left.Primitive = reference.Primitive;
+            right.Primitive = reference.Primitive;
+            for (int i = 0; i < 3; ++i) {
+                Vector3<float> const& from = triangle[i];
+                Vector3<float> const& to = triangle[(i + 1) % 3];
+                float const p0 = Component(from, axis);
+                float const p1 = Component(to, axis);
+                if (p0 <= position) {
+                    left.Bounds.Grow(from);
+                }
+                if (p0 >= position) {
+                    right.Bounds.Grow(from);
+                }
+                if ((p0 < position && position < p1) || (p1 < position && position < p0)) {
+                    Vector3<float> point = from + (to - from) * ((position - p0) / (p1 - p0));
+                    SetComponent(point, axis, position);
+                    left.Bounds.Grow(point);
+                    right.Bounds.Grow(point);
+                }
+            }
+            left.Bounds.Clip(reference.Bounds);
+            right.Bounds.Clip(reference.Bounds);
+        }
+
+        // Top-down SAH build over triangle references. Where the best object split leaves
+        // children that overlap, spatial splits are binned too and straddling references are
+        // clipped into both children, as long as the duplication budget allows.
+        struct SpatialBuilder {
+            SpatialBuilder(std::vector<TriangleVertices> const& triangles, std::uint32_t budget, float rootArea,
+                           LargeArray<BVHNode>& nodes, ThreadPool& pool)
+                : Triangles(triangles), Nodes(nodes), Pool(pool), Budget(budget), RootArea(rootArea), NodeCount(1),
+                  SlotCount(0), References(static_cast<std::uint32_t>(triangles.size())) {
+                Slots.resize(budget);
+            }
+
+            void    Build(std::uint32_t nodeIndex, std::vector<Reference> references, unsigned int depth, TaskGroup& group) {
+                AABB bounds;
+                AABB centroids;
+                for (Reference const& reference : references) {
+                    bounds.Grow(reference.Bounds);
+                    centroids.Grow(reference.Bounds.Centroid());
+                }
+                BVHNode& node = Nodes[nodeIndex];
+                node.Bounds = bounds;
+                std::uint32_t const count = static_cast<std::uint32_t>(references.size());
+                if (count == 1 || depth + 1 >= BVH::MaxDepth) {
+                    _makeLeaf(node, references);
+                    return;
+                }
+
+                Split const object = _findObjectSplit(references, centroids);
+                Split spatial;
+                AABB overlap = object.Left;
+                overlap.Clip(object.Right);
+                if (object.Axis < 0 || overlap.Area() > BVH::SpatialAlpha * RootArea) {
+                    spatial = _findSpatialSplit(references, bounds);
+                }
+                // Leaf cost is one intersection per reference, a split adds one traversal step
+                float const area = bounds.Area();
+                float const splitCost = area > 0.f ? 1.f + std::min(object.Cost, spatial.Cost) / area : static_cast<float>(count);
+                if (count <= BVH::MaxLeafSize && splitCost >= count) {
+                    _makeLeaf(node, references);
+                    return;
+                }
+
+                std::vector<Reference> left;
+                std::vector<Reference> right;
+                bool split = spatial.Cost < object.Cost && _partitionSpatial(references, bounds, spatial, left, right);
+                if (!split && object.Axis >= 0) {
+                    _partitionObject(references, centroids, object, left, right);
+                    split = !left.empty() && !right.empty();
+                }
+                if (!split) {
+                    left.assign(references.begin(), references.begin() + count / 2);
+                    right.assign(references.begin() + count / 2, references.end());
+                }
+                std::vector<Reference>().swap(references);
+
+                std::uint32_t const children = NodeCount.fetch_add(2, std::memory_order_relaxed);
+                node.Offset = children;
+                node.Count = 0;
+                if (count >= BVH::ParallelThreshold) {
+                    group.Run([this, children, left = std::move(left), depth, &group]() mutable {
+                        Build(children, std::move(left), depth + 1, group);
+                    });
+                } else {
+                    Build(children, std::move(left), depth + 1, group);
+                }
+                Build(children + 1, std::move(right), depth + 1, group);
+            }
+
+            std::vector<TriangleVertices> const&    Triangles;
+            LargeArray<BVHNode>&                    Nodes;
+            // Leaf primitives in allocation order, laid out depth first once the build is done
+            std::vector<std::uint32_t>              Slots;
+            ThreadPool&                             Pool;
+            std::uint32_t const                     Budget;
+            float const                             RootArea;
+            std::atomic<std::uint32_t>              NodeCount;
+            std::atomic<std::uint32_t>              SlotCount;
+            std::atomic<std::uint32_t>              References;
+
+        private:
+            void    _makeLeaf(BVHNode& node, std::vector<Reference> const& references) {
+                std::uint32_t const count = static_cast<std::uint32_t>(references.size());
+                std::uint32_t const slot = SlotCount.fetch_add(count, std::memory_order_relaxed);
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    Slots[slot + i] = references[i].Primitive;
+                }
+                node.Offset = slot;
+                node.Count = count;
+            }
+
+            // Bins large nodes in parallel, one partial result per chunk
+            template <class T, class Body>
+            std::vector<T>  _reduce(std::size_t count, Body const& body) {
+                std::size_t const chunks = count < BVH::ParallelThreshold ? 1
+                    : std::min<std::size_t>(Pool.GetThreadCount() * 4, count / ParallelGrain + 1);
+                std::vector<T> partials(chunks);
+                if (chunks == 1) {
+                    body(0, count, partials[0]);
+                    return partials;
+                }
+                Pool.ParallelFor(chunks, 1, [&](std::size_t first, std::size_t last) {
+                    for (std::size_t chunk = first; chunk < last; ++chunk) {
+                        body(count * chunk / chunks, count * (chunk + 1) / chunks, partials[chunk]);
+                    }
+                });
+                return partials;
+            }
+
+            Split   _findObjectSplit(std::vector<Reference> const& references, AABB const& centroids) {
+                Vector3<float> const extent = centroids.Extent();
+                auto partials = _reduce<ObjectBins>(references.size(), [&](std::size_t first, std::size_t last, ObjectBins& bins) {
+                    for (std::size_t i = first; i < last; ++i) {
+                        Vector3<float> const centroid = references[i].Bounds.Centroid();
+                        for (int a = 0; a < 3; ++a) {
+                            if (Component(extent, a) <= 0.f) {
+                                continue;
+                            }
+                            ObjectBin& bin = bins[a][binOf(Component(centroid, a), Component(centroids.Min, a),
+                                                           BVH::BinCount / Component(extent, a))];
+                            bin.Bounds.Grow(references[i].Bounds);
+                            ++bin.Count;
+                        }
+                    }
+                });
+                ObjectBins bins = partials[0];
+                for (std::size_t p = 1; p < partials.size(); ++p) {
+                    for (int a = 0; a < 3; ++a) {
+                        for (unsigned int b = 0; b < BVH::BinCount; ++b) {
+                            bins[a][b].Bounds.Grow(partials[p][a][b].Bounds);
+                            bins[a][b].Count += partials[p][a][b].Count;
+                        }
+                    }
+                }
+
+                Split best;
+                for (int a = 0; a < 3; ++a) {
+                    std::array<AABB, BVH::BinCount> rightBounds;
+                    std::array<std::uint32_t, BVH::BinCount> rightCount{};
+                    AABB box;
+                    std::uint32_t count = 0;
+                    for (unsigned int b = BVH::BinCount - 1; b > 0; --b) {
+                        box.Grow(bins[a][b].Bounds);
+                        count += bins[a][b].Count;
+                        rightBounds[b] = box;
+                        rightCount[b] = count;
+                    }
+                    box = AABB();
+                    count = 0;
+                    for (unsigned int b = 1; b < BVH::BinCount; ++b) {
+                        box.Grow(bins[a][b - 1].Bounds);
+                        count += bins[a][b - 1].Count;
+                        if (count == 0 || rightCount[b] == 0) {
+                            continue;
+                        }
+                        float const cost = box.Area() * count + rightBounds[b].Area() * rightCount[b];
+                        if (cost < best.Cost) {
+                            best.Cost = cost;
+                            best.Axis = a;
+                            best.Bin = b;
+                            best.Left = box;
+                            best.Right = rightBounds[b];
+                        }
+                    }
+                }
+                return best;
+            }
+
+            Split   _findSpatialSplit(std::vector<Reference> const& references, AABB const& bounds) {
+                Vector3<float> const extent = bounds.Extent();
+                auto partials = _reduce<SpatialBins>(references.size(), [&](std::size_t first, std::size_t last, SpatialBins& bins) {
+                    for (std::size_t i = first; i < last; ++i) {
+                        for (int a = 0; a < 3; ++a) {
+                            float const size = Component(extent, a);
+                            if (size <= 0.f) {
+                                continue;
+                            }
+                            float const minimum = Component(bounds.Min, a);
+                            float const scale = BVH::BinCount / size;
+                            std::uint32_t const firstBin = binOf(Component(references[i].Bounds.Min, a), minimum, scale);
+                            std::uint32_t const lastBin = binOf(Component(references[i].Bounds.Max, a), minimum, scale);
+                            ++bins[a][firstBin].Entries;
+                            ++bins[a][lastBin].Exits;
+                            // Chop the reference at every plane it crosses
+                            Reference rest = references[i];
+                            for (std::uint32_t b = firstBin; b < lastBin; ++b) {
+                                Reference piece;
+                                Reference remainder;
+                                splitReference(Triangles[rest.Primitive], rest, a, minimum + size * (b + 1) / BVH::BinCount,
+                                               piece, remainder);
+                                bins[a][b].Bounds.Grow(piece.Bounds);
+                                rest = remainder;
+                            }
+                            bins[a][lastBin].Bounds.Grow(rest.Bounds);
+                        }
+                    }
+                });
+                SpatialBins bins = partials[0];
+                for (std::size_t p = 1; p < partials.size(); ++p) {
+                    for (int a = 0; a < 3; ++a) {
+                        for (unsigned int b = 0; b < BVH::BinCount; ++b) {
+                            bins[a][b].Bounds.Grow(partials[p][a][b].Bounds);
+                            bins[a][b].Entries += partials[p][a][b].Entries;
+                            bins[a][b].Exits += partials[p][a][b].Exits;
+                        }
+                    }
+                }
+
+                Split best;
+                for (int a = 0; a < 3; ++a) {
+                    std::array<float, BVH::BinCount> rightCost{};
+                    AABB box;
+                    std::uint32_t count = 0;
+                    for (unsigned int b = BVH::BinCount - 1; b > 0; --b) {
+                        box.Grow(bins[a][b].Bounds);
+                        count += bins[a][b].Exits;
+                        rightCost[b] = count > 0 ? box.Area() * count : -1.f;
+                    }
+                    box = AABB();
+                    count = 0;
+                    for (unsigned int b = 1; b < BVH::BinCount; ++b) {
+                        box.Grow(bins[a][b - 1].Bounds);
+                        count += bins[a][b - 1].Entries;
+                        if (count == 0 || rightCost[b] < 0.f) {
+                            continue;
+                        }
+                        float const cost = box.Area() * count + rightCost[b];
+                        if (cost < best.Cost) {
+                            best.Cost = cost;
+                            best.Axis = a;
+                            best.Bin = b;
+                        }
+                    }
+                }
+                return best;
+            }
+
+            void    _partitionObject(std::vector<Reference> const& references, AABB const& centroids, Split const& split,
+                                     std::vector<Reference>& left, std::vector<Reference>& right) {
+                float const minimum = Component(centroids.Min, split.Axis);
+                float const scale = BVH::BinCount / Component(centroids.Extent(), split.Axis);
+                for (Reference const& reference : references) {
+                    bool const isLeft = binOf(Component(reference.Bounds.Centroid(), split.Axis), minimum, scale) < split.Bin;
+                    (isLeft ? left : right).push_back(reference);
+                }
+            }
+
+            // Returns false, leaving both sides empty, when the duplicated references would exceed the budget
+            bool    _partitionSpatial(std::vector<Reference> const& references, AABB const& bounds, Split const& split,
+                                      std::vector<Reference>& left, std::vector<Reference>& right) {
+                float const position = Component(bounds.Min, split.Axis)
+                                     + Component(bounds.Extent(), split.Axis) * split.Bin / BVH::BinCount;
+                std::uint32_t duplicates = 0;
+                for (Reference const& reference : references) {
+                    if (Component(reference.Bounds.Max, split.Axis) <= position) {
+                        left.push_back(reference);
+                    } else if (Component(reference.Bounds.Min, split.Axis) >= position) {
+                        right.push_back(reference);
+                    } else {
+                        Reference piece;
+                        Reference remainder;
+                        splitReference(Triangles[reference.Primitive], reference, split.Axis, position, piece, remainder);
+                        if (!piece.Bounds.IsEmpty()) {
+                            left.push_back(piece);
+                        }
+                        if (!remainder.Bounds.IsEmpty()) {
+                            right.push_back(remainder);
+                        }
+                        duplicates += !piece.Bounds.IsEmpty() && !remainder.Bounds.IsEmpty();
+                    }
+                }
+
+                std::uint32_t total = References.load(std::memory_order_relaxed);
+                do {
+                    if (left.empty() || right.empty() || total + duplicates > Budget) {
+                        left.clear();
+                        right.clear();
+                        return false;
+                    }
+                } while (!References.compare_exchange_weak(total, total + duplicates, std::memory_order_relaxed));
+                return true;
+            }
+        };
+    }
+
+    void BVH::BuildSpatial(std::vector<TriangleVertices> const& triangles, float maxOverhead, ThreadPool& pool) {
+        auto const start = std::chrono::steady_clock::now();
+        std::uint32_t const count = static_cast<std::uint32_t>(triangles.size());
+        std::uint32_t const budget = count + static_cast<std::uint32_t>(count * std::max(maxOverhead, 0.f));
+        std::vector<Reference> references(count);
+        AABB bounds;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            for (Vector3<float> const& vertex : triangles[i]) {
+                references[i].Bounds.Grow(vertex);
+            }
+            references[i].Primitive = i;
+            bounds.Grow(references[i].Bounds);
+        }
+
+        _nodes.assign(count > 0 ? 2 * budget : 0, BVHNode());
+        _indices.clear();
+        std::uint32_t nodeCount = 0;
+        if (count > 0) {
+            SpatialBuilder sbvh(triangles, budget, bounds.Area(), _nodes, pool);
+            TaskGroup group(pool);
+            sbvh.Build(0, std::move(references), 0, group);
+            group.Wait();
+            nodeCount = sbvh.NodeCount;
+
+            // Leaves took their slots in whatever order tasks finished, lay them out depth first
+            _indices.reserve(sbvh.SlotCount);
+            std::vector<std::uint32_t> stack{0};
+            while (!stack.empty()) {
+                BVHNode& node = _nodes[stack.back()];
+                stack.pop_back();
+                if (node.IsLeaf()) {
+                    std::uint32_t const offset = static_cast<std::uint32_t>(_indices.size());
+                    _indices.insert(_indices.end(), sbvh.Slots.begin() + node.Offset, sbvh.Slots.begin() + node.Offset + node.Count);
+                    node.Offset = offset;
+                } else {
+                    stack.push_back(node.Offset + 1);
+                    stack.push_back(node.Offset);
+                }
+            }
+        }
+        _nodes.resize(nodeCount);
+        _nodes.shrink_to_fit();
+
+        _stats = BVHStats();
+        _stats.Builder = BVHBuilder::SBVH;
+        _stats.Primitives = count;
+        _stats.References = _indices.size();
+        _stats.BuildTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        _computeStats();
+    }
+}  // namespace rt
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include "WideBVH.h"
+
+namespace rt {
+    template <unsigned int Width>
+    void WideBVH<Width>::Build(BVH const& binary) {
+        auto const start = std::chrono::steady_clock::now();
+        _nodes.clear();
+        LargeArray<BVHNode> const& nodes = binary.GetNodes();
+        if (!nodes.empty()) {
+            _nodes.reserve(nodes.size() / 2 + 1);
+            _collapse(nodes, 0);
+        }
+        _nodes.shrink_to_fit();
+
+        _stats = WideBVHStats();
+        _stats.Width = Width;
+        _stats.Nodes = _nodes.size();
+        _stats.Bytes = _nodes.size() * sizeof(WideNode<Width>);
+        _stats.BinaryBytes = nodes.size() * sizeof(BVHNode);
+        std::size_t children = 0;
+        for (auto const& node : _nodes) {
+            children += node.ChildCount;
+        }
+        _stats.Fill = _nodes.empty() ? 0.f : static_cast<float>(children) / (_nodes.size() * Width);
+        _stats.CollapseTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template <unsigned int Width>
+    WideBVHStats const& WideBVH<Width>::GetStats() const {
+        return _stats;
+    }
+
+    template <unsigned int Width>
+    void WideBVH<Width>::Cull(Frustum const& frustum, std::vector<TraversalRoot>& roots) const {
+        roots.clear();
+        if (_nodes.empty()) {
+            return;
+        }
+        auto children = [&](TraversalRoot const& root, TraversalRoot* out) {
+            WideNode<Width> const& node = _nodes[root.Index];
+            std::size_t count = 0;
+            for (unsigned int child = 0; child < node.ChildCount; ++child) {
+                AABB const bounds = _childBounds(node, child);
+                if (frustum.Overlaps(bounds)) {
+                    out[count++] = TraversalRoot{bounds, node.Child[child], node.Count[child]};
+                }
+            }
+            return count;
+        };
+        // The root node has no box of its own, so its children start the list
+        TraversalRoot opened[Width];
+        roots.assign(opened, opened + children(TraversalRoot(), opened));
+        ExpandRoots(roots, BVH::MaxRoots, children);
+    }
+
+    template <unsigned int Width>
+    AABB WideBVH<Width>::_childBounds(WideNode<Width> const& node, unsigned int child) const {
+        float min[3];
+        float max[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            float const step = ExponentScale(node.Exponent[axis]);
+            min[axis] = node.Origin[axis] + (node.QMin[axis][child] - 1) * step;
+            max[axis] = node.Origin[axis] + (node.QMax[axis][child] + 1) * step;
+        }
+        AABB bounds;
+        bounds.Min = Vector3<float>(min[0], min[1], min[2]);
+        bounds.Max = Vector3<float>(max[0], max[1], max[2]);
+        return bounds;
+    }
+
+    template <unsigned int Width>
+    std::uint32_t WideBVH<Width>::_collapse(LargeArray<BVHNode> const& binary, std::uint32_t index) {
+        // Pull grandchildren up, always opening the interior child with the largest surface
+        // area, since it is the most likely to be entered
+        std::uint32_t children[Width];
+        unsigned int count = 0;
+        if (binary[index].IsLeaf()) {
+            children[count++] = index;
+        } else {
+            children[count++] = binary[index].Offset;
+            children[count++] = binary[index].Offset + 1;
+        }
+        while (count < Width) {
+            int widest = -1;
+            float widestArea = -1.f;
+            for (unsigned int i = 0; i < count; ++i) {
+                if (!binary[children[i]].IsLeaf() && binary[children[i]].Bounds.Area() > widestArea) {
+                    widest = static_cast<int>(i);
+                    widestArea = binary[children[i]].Bounds.Area();
+                }
+            }
+            if (widest < 0) {
+                break;
+            }
+            std::uint32_t const opened = children[widest];
+            children[widest] = binary[opened].Offset;
+            children[count++] = binary[opened].Offset + 1;
+        }
+
+        std::uint32_t const nodeIndex = static_cast<std::uint32_t>(_nodes.size());
+        _nodes.emplace_back();
+        WideNode<Width> node;
+        std::memset(&node, 0, sizeof(node));
+        node.ChildCount = static_cast<std::uint8_t>(count);
+
+        // Quantization grid: the smallest power of two step that spans the node in 255 steps
+        AABB const& bounds = binary[index].Bounds;
+        float const boundsMin[3] = {bounds.Min.X, bounds.Min.Y, bounds.Min.Z};
+        float const boundsMax[3] = {bounds.Max.X, bounds.Max.Y, bounds.Max.Z};
+        float scale[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            float const extent = boundsMax[axis] - boundsMin[axis];
+            int exponent = extent > 0.f ? static_cast<int>(std::ceil(std::log2(extent / 255.f))) : -126;
+            exponent = std::min(std::max(exponent, -126), 127);
+            while (exponent < 127 && ExponentScale(static_cast<std::int8_t>(exponent)) * 255.f < extent) {
+                ++exponent;
+            }
+            node.Origin[axis] = boundsMin[axis];
+            node.Exponent[axis] = static_cast<std::int8_t>(exponent);
+            scale[axis] = ExponentScale(node.Exponent[axis]);
+        }
+
+        for (unsigned int i = 0; i < count; ++i) {
+            BVHNode const& child = binary[children[i]];
+            float const childMin[3] = {child.Bounds.Min.X, child.Bounds.Min.Y, child.Bounds.Min.Z};
+            float const childMax[3] = {child.Bounds.Max.X, child.Bounds.Max.Y, child.Bounds.Max.Z};
+            for (int axis = 0; axis < 3; ++axis) {
+                float low = std::floor((childMin[axis] - node.Origin[axis]) / scale[axis]);
+                float high = std::ceil((childMax[axis] - node.Origin[axis]) / scale[axis]);
+                low = std::min(std::max(low, 0.f), 255.f);
+                high = std::min(std::max(high, 0.f), 255.f);
+                // The decoded box must strictly contain the child so rounding in traversal cannot clip it
+                while (low > 0.f && node.Origin[axis] + low * scale[axis] >= childMin[axis]) {
+                    low -= 1.f;
+                }
+                while (high < 255.f && node.Origin[axis] + high * scale[axis] <= childMax[axis]) {
+                    high += 1.f;
+                }
+                node.QMin[axis][i] = static_cast<std::uint8_t>(low);
+                node.QMax[axis][i] = static_cast<std::uint8_t>(high);
+            }
+            if (child.IsLeaf()) {
+                node.Child[i] = child.Offset;
+                node.Count[i] = static_cast<std::uint16_t>(child.Count);
+            }
+        }
+        for (unsigned int i = 0; i < count; ++i) {
+            if (!binary[children[i]].IsLeaf()) {
+                node.Child[i] = _collapse(binary, children[i]);
+            }
+        }
+        _nodes[nodeIndex] = node;
+        return nodeIndex;
+    }
+
+    template class WideBVH<4>;
+    template class WideBVH<8>;
+
+    void ReportWide(WideBVHStats const& stats, std::ostream& out) {
+        out << std::fixed << std::setprecision(2)
+            << "BVH" << stats.Width << ": " << stats.Nodes << " nodes of " << stats.Bytes / std::max<std::size_t>(stats.Nodes, 1)
+            << " bytes, " << stats.Bytes / 1024.f << " KiB (binary " << stats.BinaryBytes / 1024.f << " KiB), "
+            << 100.f * stats.Fill << "% of child slots used, collapsed in " << stats.CollapseTime << " ms" << std::endl;
+    }
+}  // namespace rt
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <vector>
+#include "../Engine/Tools.h"
+#include "BVH.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RT_ACCEL_SSE
+#endif
+
+namespace rt {
+    // Child boxes are stored as 8-bit offsets on a per-node power-of-two grid anchored at
+    // Origin, rounded outwards so the decoded box always contains the real one.
+    // A 4-wide node fills one 64-byte cache line, an 8-wide node two.
+    template <unsigned int Width>
+    struct alignas(64) WideNode {
+        float           Origin[3];
+        std::int8_t     Exponent[3];
+        std::uint8_t    ChildCount;
+        std::uint8_t    QMin[3][Width];
+        std::uint8_t    QMax[3][Width];
+        // Interior children hold a node index, leaves the first leaf slot
+        std::uint32_t   Child[Width];
+        // Primitives per leaf child, 0 for interior children
+        std::uint16_t   Count[Width];
+    };
+
+    struct WideBVHStats {
+        unsigned int    Width = 2;
+        std::size_t     Nodes = 0;
+        std::size_t     Bytes = 0;
+        std::size_t     BinaryBytes = 0;
+        float           Fill = 0.f;
+        float           CollapseTime = 0.f;
+    };
+
+    // Collapses a binary BVH into Width-ary quantized nodes whose child boxes are
+    // tested together, four lanes per SSE operation. Leaf slots keep the binary order.
+    template <unsigned int Width>
+    class WideBVH {
+    public:
+        static_assert(Width == 4 || Width == 8, "WideBVH supports 4 and 8 children");
+
+        void    Build(BVH const& binary);
+
+        WideBVHStats const&     GetStats() const;
+
+        // Same contract as BVH::Traverse
+        template <class Visit>
+        void    Traverse(Ray const& ray, float tMax, Visit&& visit) const {
+            _traverse<false>(ray, tMax, visit, nullptr);
+        }
+        template <class Visit>
+        void    Traverse(Ray const& ray, float tMax, Visit&& visit, TraversalCost& cost) const {
+            _traverse<true>(ray, tMax, visit, &cost);
+        }
+        template <class Visit>
+        void    TraverseFrom(std::vector<TraversalRoot> const& roots, Ray const& ray, float tMax, Visit&& visit) const {
+            _traverse<false>(ray, tMax, visit, nullptr, &roots);
+        }
+        template <class Visit>
+        void    TraverseFrom(std::vector<TraversalRoot> const& roots, Ray const& ray, float tMax, Visit&& visit, TraversalCost& cost) const {
+            _traverse<true>(ray, tMax, visit, &cost, &roots);
+        }
+        // Same contract as BVH::Cull. The roots carry their decoded boxes grown by one grid step,
+        // so testing a ray against them never rejects one the quantized test would accept.
+        void    Cull(Frustum const& frustum, std::vector<TraversalRoot>& roots) const;
+
+        static constexpr unsigned int StackSize = BVH::MaxDepth * (Width - 1) + 1;
+
+    private:
+        LargeArray<WideNode<Width>>     _nodes;
+        WideBVHStats                    _stats;
+
+        std::uint32_t   _collapse(LargeArray<BVHNode> const& binary, std::uint32_t index);
+        unsigned int    _hitChildren(WideNode<Width> const& node, Vector3<float> const& origin, Vector3<float> const& inverseDir,
+                                     float tMax, float* tNear) const;
+        AABB            _childBounds(WideNode<Width> const& node, unsigned int child) const;
+        template <bool Counted, class Visit>
+        void            _traverse(Ray const& ray, float tMax, Visit& visit, TraversalCost* cost,
+                                  std::vector<TraversalRoot> const* roots = nullptr) const;
+    };
+
+    void    ReportWide(WideBVHStats const& stats, std::ostream& out);
+
+    // 2^exponent built directly from the float's exponent bits, exponent in [-126, 127]
+    inline float ExponentScale(std::int8_t exponent) {
+        std::uint32_t const bits = static_cast<std::uint32_t>(exponent + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return scale;
+    }
+
+    template <unsigned int Width>
+    inline unsigned int WideBVH<Width>::_hitChildren(WideNode<Width> const& node, Vector3<float> const& origin,
+                                                     Vector3<float> const& inverseDir, float tMax, float* tNear) const {
+        // Decoded plane: origin + q * 2^e, so the ray distance is q * a + b per axis
+        float a[3];
+        float b[3];
+        float const rayOrigin[3] = {origin.X, origin.Y, origin.Z};
+        float const rayInverse[3] = {inverseDir.X, inverseDir.Y, inverseDir.Z};
+        for (int axis = 0; axis < 3; ++axis) {
+            a[axis] = ExponentScale(node.Exponent[axis]) * rayInverse[axis];
+            b[axis] = (node.Origin[axis] - rayOrigin[axis]) * rayInverse[axis];
+        }
+        unsigned int mask = 0;
+        #ifdef RT_ACCEL_SSE
+        __m128i const zero = _mm_setzero_si128();
+        for (unsigned int group = 0; group < Width; group += 4) {
+            __m128 near = _mm_setzero_ps();
+            __m128 far = _mm_set1_ps(tMax);
+            for (int axis = 0; axis < 3; ++axis) {
+                std::int32_t minBytes;
+                std::int32_t maxBytes;
+                std::memcpy(&minBytes, &node.QMin[axis][group], 4);
+                std::memcpy(&maxBytes, &node.QMax[axis][group], 4);
+                __m128 const qMin = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(minBytes), zero), zero));
+                __m128 const qMax = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(maxBytes), zero), zero));
+                __m128 const scale = _mm_set1_ps(a[axis]);
+                __m128 const offset = _mm_set1_ps(b[axis]);
+                __m128 const t1 = _mm_add_ps(_mm_mul_ps(qMin, scale), offset);
+                __m128 const t2 = _mm_add_ps(_mm_mul_ps(qMax, scale), offset);
+                near = _mm_max_ps(near, _mm_min_ps(t1, t2));
+                far = _mm_min_ps(far, _mm_max_ps(t1, t2));
+            }
+            _mm_storeu_ps(tNear + group, near);
+            mask |= static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(near, far))) << group;
+        }
+        #else
+        for (unsigned int child = 0; child < Width; ++child) {
+            float near = 0.f;
+            float far = tMax;
+            for (int axis = 0; axis < 3; ++axis) {
+                float const t1 = node.QMin[axis][child] * a[axis] + b[axis];
+                float const t2 = node.QMax[axis][child] * a[axis] + b[axis];
+                near = std::max(near, std::min(t1, t2));
+                far = std::min(far, std::max(t1, t2));
+            }
+            tNear[child] = near;
+            mask |= (near <= far ? 1u : 0u) << child;
+        }
+        #endif
+        return mask & ((1u << node.ChildCount) - 1u);
+    }
+
+    template <unsigned int Width>
+    template <bool Counted, class Visit>
+    void WideBVH<Width>::_traverse(Ray const& ray, float tMax, Visit& visit, TraversalCost* cost,
+                                   std::vector<TraversalRoot> const* roots) const {
+        if (_nodes.empty()) {
+            return;
+        }
+        struct Entry {
+            std::uint32_t   Child;
+            std::uint32_t   Count;
+            float           Near;
+        };
+        Vector3<float> const inverseDir = InverseDirection(ray.Direction);
+        Entry stack[StackSize + BVH::MaxRoots];
+        unsigned int top = 0;
+        if (roots == nullptr) {
+            stack[top++] = Entry{0, 0, 0.f};
+        } else {
+            for (TraversalRoot const& root : *roots) {
+                Entry const hit{root.Index, root.Count, root.Bounds.Hit(ray.Origin, inverseDir, tMax)};
+                if (hit.Near == std::numeric_limits<float>::infinity()) {
+                    continue;
+                }
+                unsigned int position = top++;
+                while (position > 0 && stack[position - 1].Near < hit.Near) {
+                    stack[position] = stack[position - 1];
+                    --position;
+                }
+                stack[position] = hit;
+            }
+        }
+        float tNear[Width];
+        while (top > 0) {
+            Entry const entry = stack[--top];
+            if (entry.Near > tMax) {
+                continue;
+            }
+            if (entry.Count > 0) {
+                for (std::uint32_t slot = entry.Child; slot < entry.Child + entry.Count; ++slot) {
+                    if constexpr (Counted) {
+                        ++cost->Triangles;
+                    }
+                    if (visit(slot, tMax)) {
+                        return;
+                    }
+                }
+                continue;
+            }
+            WideNode<Width> const& node = _nodes[entry.Child];
+            if constexpr (Counted) {
+                ++cost->Nodes;
+            }
+            unsigned int mask = _hitChildren(node, ray.Origin, inverseDir, tMax, tNear);
+            // Push hit children far to near so the nearest is popped first
+            unsigned int const first = top;
+            while (mask != 0) {
+                unsigned int child = 0;
+                while ((mask & (1u << child)) == 0) {
+                    ++child;
+                }
+                mask &= mask - 1;
+                Entry const hit{node.Child[child], node.Count[child], tNear[child]};
+                unsigned int position = top++;
+                while (position > first && stack[position - 1].Near < hit.Near) {
+                    stack[position] = stack[position - 1];
+                    --position;
+                }
+                stack[position] = hit;
+            }
+        }
+    }
+}  // namespace rt
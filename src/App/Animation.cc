@@ -0,0 +1,78 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../Camera/CameraPath.h"
+#include "../Camera/PoseFile.h"
+#include "../Engine/Engine.h"
+#include "../Engine/Memory.h"
+#include "../Loader/AssimpLoader.h"
+#include "../Render/AnimationRenderer.h"
+#include "../Render/VideoWriter.h"
+#include "Modes.h"
+
+namespace rt {
+    namespace {
+        bool endsWith(std::string const& value, std::string const& suffix) {
+            return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+    }
+
+    int RunAnimation(Options const& options) {
+        std::vector<CameraPose> keys;
+        if (options.Poses != "demo" && !ReadPoses(options.Poses, keys)) {
+            return 1;
+        }
+        AssimpLoader loader;
+        loader.SetLodOptions(options.Lod);
+        std::cout << "Loading scene " << options.Scene << "..." << std::endl;
+        if (!loader.LoadFile(options.Scene)) {
+            return 1;
+        }
+        loader.GetScene().Report(std::cout);
+        Engine engine{loader.TakeScene(), options.Accel};
+        BVH::Report(engine.GetBVHStats(), std::cout);
+        ReportMemory(std::cout);
+        engine.SetShading(GetShadingOptions(options));
+        engine.ReportKernel(std::cout);
+        Camera camera = *engine.GetCamera();
+        camera.SetFOV(options.FOV);
+        camera.SetRes(options.Res);
+        engine.SetLevelOfDetail(options.LodPixels * camera.GetPixelAngle());
+        engine.ReportLods(std::cout);
+
+        CameraPath path;
+        if (options.Poses == "demo") {
+            path = CameraPath::Demo(camera, options.Frames > 0 ? options.Frames : CameraPath::DemoMoves);
+        } else {
+            path = CameraPath::Interpolate(keys, options.Frames > 0 ? options.Frames : keys.size());
+        }
+        if (path.GetFrameCount() == 0) {
+            std::cerr << "Camera path is empty" << std::endl;
+            return 1;
+        }
+
+        VideoWriter video;
+        bool const toVideo = endsWith(options.Output, ".y4m");
+        if (toVideo && !video.Open(options.Output, options.Res, static_cast<unsigned int>(std::lround(options.Fps)))) {
+            return 1;
+        }
+        ThreadPool pool(options.Threads);
+        AnimationRenderer renderer(engine, pool, camera, options.Spp);
+        renderer.SetRasterization(options.Rasterize);
+        std::cout << "Rendering " << path.GetFrameCount() << " frame(s) on " << pool.GetThreadCount() << " thread(s)" << std::endl;
+        AnimationStats const stats = renderer.Render(path, [&](std::size_t frame, Image const& image) {
+            return toVideo ? video.Write(image) : image.WritePPM(NumberedPath(options.Output, frame));
+        });
+        AnimationRenderer::Report(stats, std::cout);
+        if (options.AO.Samples > 0) {
+            engine.ReportAO(stats.WallTime, std::cout);
+        } else {
+            engine.ReportLights(std::cout);
+        }
+        engine.ReportCulling(std::cout);
+        if (options.Rasterize) {
+            engine.ReportVisibility(std::cout);
+        }
+        return stats.Frames == path.GetFrameCount() ? 0 : 1;
+    }
+}  // namespace rt
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../Camera/PoseFile.h"
+#include "../Engine/Engine.h"
+#include "../Engine/Memory.h"
+#include "../Engine/Numa.h"
+#include "../Loader/AssimpLoader.h"
+#include "../Render/BatchRenderer.h"
+#include "Modes.h"
+
+namespace rt {
+    int RunBatch(Options const& options) {
+        std::vector<CameraPose> poses;
+        if (!ReadPoses(options.Poses, poses)) {
+            return 1;
+        }
+        AssimpLoader loader;
+        loader.SetLodOptions(options.Lod);
+        std::cout << "Loading scene " << options.Scene << "..." << std::endl;
+        if (!loader.LoadFile(options.Scene)) {
+            return 1;
+        }
+        loader.GetScene().Report(std::cout);
+        Engine engine{loader.TakeScene(), options.Accel};
+        BVH::Report(engine.GetBVHStats(), std::cout);
+        ReportMemory(std::cout);
+        engine.SetShading(GetShadingOptions(options));
+        engine.ReportKernel(std::cout);
+        Camera camera = *engine.GetCamera();
+        camera.SetFOV(options.FOV);
+        camera.SetRes(options.Res);
+        engine.SetLevelOfDetail(options.LodPixels * camera.GetPixelAngle());
+        engine.ReportLods(std::cout);
+
+        std::unique_ptr<EngineReplicas> replicas;
+        ThreadPool::WorkerStart pin;
+        if (options.Numa) {
+            std::vector<NumaNode> nodes = ReadNumaTopology();
+            ReportNuma(nodes, std::cout);
+            replicas = std::make_unique<EngineReplicas>(engine, std::move(nodes), options.Threads);
+            pin = [&replicas](unsigned int worker) {
+                replicas->PinWorker(worker);
+            };
+            ReportMemory(std::cout);
+        }
+        ThreadPool pool(options.Threads, pin);
+        BatchRenderer renderer(engine, pool, camera, options.Spp);
+        renderer.SetReplicas(replicas.get());
+        renderer.SetRasterization(options.Rasterize);
+        std::cout << "Rendering " << poses.size() << " view(s) on " << pool.GetThreadCount() << " thread(s)" << std::endl;
+        BatchStats const stats = renderer.Render(poses, [&options](std::size_t index, Image const& image) {
+            return image.WritePPM(NumberedPath(options.Output, index));
+        });
+        if (replicas) {
+            replicas->GatherCounters();
+        }
+        BatchRenderer::Report(stats, std::cout);
+        if (options.AO.Samples > 0) {
+            engine.ReportAO(stats.WallTime, std::cout);
+        } else {
+            engine.ReportLights(std::cout);
+        }
+        engine.ReportCulling(std::cout);
+        if (options.Rasterize) {
+            engine.ReportVisibility(std::cout);
+        }
+        return stats.Written == poses.size() ? 0 : 1;
+    }
+}  // namespace rt
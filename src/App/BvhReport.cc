@@ -0,0 +1,65 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include "../Engine/Engine.h"
+#include "../Engine/Memory.h"
+#include "../Loader/AssimpLoader.h"
+#include "../Render/Image.h"
+#include "../Render/ThreadPool.h"
+#include "../Render/TileRenderer.h"
+#include "Modes.h"
+
+namespace rt {
+    int RunBvhReport(Options const& options) {
+        AssimpLoader loader;
+        std::cout << "Loading scene " << options.Scene << "..." << std::endl;
+        if (!loader.LoadFile(options.Scene)) {
+            return 1;
+        }
+        Scene const scene = loader.TakeScene();
+        scene.Report(std::cout);
+        ThreadPool pool(options.Threads);
+        // Binned SAH results per width, the baseline for the spatial split gains
+        float sahCost = 0.f;
+        float sahFrame[3] = {};
+        for (BVHBuilder builder : {BVHBuilder::BinnedSAH, BVHBuilder::LBVH, BVHBuilder::SBVH}) {
+            for (unsigned int width : {2u, 4u, 8u}) {
+                AccelOptions accel;
+                accel.Builder = builder;
+                accel.Width = width;
+                accel.BuildThreads = options.Threads;
+                Engine engine{Scene(scene), accel};
+                if (width == 2) {
+                    BVH::Report(engine.GetBVHStats(), std::cout);
+                    BVH::ReportQuality(engine.GetBVHStats(), std::cout);
+                } else {
+                    ReportWide(engine.GetWideBVHStats(), std::cout);
+                }
+
+                // Trace the scene camera's view to compare traversal speed
+                Camera camera = *engine.GetCamera();
+                camera.SetFOV(options.FOV);
+                camera.SetRes(options.Res);
+                Image image(options.Res);
+                TileRenderer renderer(engine, pool);
+                auto const start = std::chrono::steady_clock::now();
+                renderer.Render(camera, Tile(0, 0, options.Res.X, options.Res.Y), options.Spp, image.Pixels.data(), image.GetStride());
+                float const seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+                double const rays = static_cast<double>(options.Res.X) * options.Res.Y * options.Spp;
+                std::cout << std::fixed << std::setprecision(2) << "    width " << width << " frame: " << seconds * 1000.f << " ms, "
+                          << rays / seconds / 1e6 << " M camera rays/s" << std::endl;
+
+                unsigned int const slot = width / 4;
+                if (builder == BVHBuilder::BinnedSAH) {
+                    sahCost = engine.GetBVHStats().SAHCost;
+                    sahFrame[slot] = seconds;
+                } else if (builder == BVHBuilder::SBVH) {
+                    std::cout << "    vs binned SAH: SAH cost " << 100.f * (engine.GetBVHStats().SAHCost / sahCost - 1.f)
+                              << "%, frame time " << 100.f * (seconds / sahFrame[slot] - 1.f) << "%" << std::endl;
+                }
+            }
+        }
+        ReportMemory(std::cout);
+        return 0;
+    }
+}  // namespace rt
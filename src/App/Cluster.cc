@@ -0,0 +1,58 @@
+#include <iostream>
+#include <vector>
+#include "../Cluster/Coordinator.h"
+#include "../Cluster/Worker.h"
+#include "../Loader/AssimpLoader.h"
+#include "Modes.h"
+
+namespace rt {
+    int RunCoordinator(Options const& options) {
+        RenderJob job;
+        job.ScenePath = options.Scene;
+        job.SceneHash = HashFile(options.Scene);
+        job.Res = options.Res;
+        job.FOV = options.FOV;
+        job.Spp = options.Spp;
+        job.Accel = options.Accel;
+        job.Shading = GetShadingOptions(options);
+        job.Lod = options.Lod;
+        job.LodPixels = options.LodPixels;
+
+        AssimpLoader loader;
+        std::cout << "Loading scene " << options.Scene << "..." << std::endl;
+        if (job.SceneHash == 0 || !loader.LoadFile(options.Scene)) {
+            return 1;
+        }
+        job.Pose = loader.GetScene().GetCamera().GetPose();
+
+        Coordinator coordinator(job, options.TileSize);
+        if (!coordinator.Listen(options.Port)) {
+            return 1;
+        }
+        std::cout << "Waiting for " << options.Workers << " worker(s) on port " << options.Port << "..." << std::endl;
+        if (!coordinator.WaitForWorkers(options.Workers)) {
+            coordinator.Shutdown();
+            return 1;
+        }
+
+        // With --scaling the same image is rendered with 1, 2, ... N workers
+        std::vector<ClusterRun> runs;
+        Image image;
+        for (unsigned int count = options.Scaling ? 1 : options.Workers; count <= options.Workers; ++count) {
+            runs.emplace_back();
+            if (!coordinator.Render(count, image, runs.back())) {
+                std::cerr << "Render failed, not every tile came back" << std::endl;
+                coordinator.Shutdown();
+                return 1;
+            }
+        }
+        coordinator.Shutdown();
+        Coordinator::Report(runs, std::cout);
+        return image.WritePPM(options.Output) ? 0 : 1;
+    }
+
+    int RunWorker(Options const& options) {
+        Worker worker(options.Threads);
+        return worker.Run(options.Host, options.Port) ? 0 : 1;
+    }
+}  // namespace rt
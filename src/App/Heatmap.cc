@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "../Engine/Engine.h"
+#include "../Engine/Memory.h"
+#include "../Loader/AssimpLoader.h"
+#include "../Render/BatchRenderer.h"
+#include "../Render/Image.h"
+#include "../Render/ThreadPool.h"
+#include "Modes.h"
+
+namespace rt {
+    namespace {
+        constexpr float HeatmapPercentile = 0.99f;
+
+        struct PixelCost {
+            TraversalCost   Primary;
+            TraversalCost   Secondary;
+            unsigned int    SecondaryRays = 0;
+        };
+
+        // Value below which the given fraction of the samples lie, so a few outliers do not darken the image
+        std::uint32_t percentile(std::vector<std::uint32_t> values, float fraction) {
+            if (values.empty()) {
+                return 0;
+            }
+            auto const nth = values.begin() + static_cast<std::ptrdiff_t>(fraction * (values.size() - 1));
+            std::nth_element(values.begin(), nth, values.end());
+            return *nth;
+        }
+
+        std::uint8_t scaleChannel(std::uint32_t value, std::uint32_t scale) {
+            return static_cast<std::uint8_t>(std::min<std::uint64_t>(255, std::uint64_t(value) * 255 / scale));
+        }
+
+        void reportCost(char const* label, TraversalCost const& total, TraversalCost const& peak, std::size_t rays, std::ostream& out) {
+            out << std::fixed << std::setprecision(2) << label << ": " << rays << " rays, "
+                << (rays > 0 ? static_cast<double>(total.Nodes) / rays : 0.0) << " nodes and "
+                << (rays > 0 ? static_cast<double>(total.Triangles) / rays : 0.0) << " triangle tests per ray, worst pixel "
+                << peak.Nodes << " nodes and " << peak.Triangles << " triangle tests" << std::endl;
+        }
+    }
+
+    int RunHeatmap(Options const& options) {
+        AssimpLoader loader;
+        loader.SetLodOptions(options.Lod);
+        std::cout << "Loading scene " << options.Scene << "..." << std::endl;
+        if (!loader.LoadFile(options.Scene)) {
+            return 1;
+        }
+        loader.GetScene().Report(std::cout);
+        Engine engine{loader.TakeScene(), options.Accel};
+        BVH::Report(engine.GetBVHStats(), std::cout);
+        BVH::ReportQuality(engine.GetBVHStats(), std::cout);
+        if (engine.GetAccelOptions().Width > 2) {
+            ReportWide(engine.GetWideBVHStats(), std::cout);
+        }
+        engine.SetShading(GetShadingOptions(options));
+        engine.ReportKernel(std::cout);
+        Camera camera = *engine.GetCamera();
+        camera.SetFOV(options.FOV);
+        camera.SetRes(options.Res);
+        engine.SetLevelOfDetail(options.LodPixels * camera.GetPixelAngle());
+        engine.ReportLods(std::cout);
+
+        // One ray through each pixel, measured in the tiles of a batch render so tile culling applies as there
+        std::vector<PixelCost> costs(static_cast<std::size_t>(options.Res.X) * options.Res.Y);
+        unsigned int const tileSize = BatchRenderer::TileSize;
+        unsigned int const tilesX = (options.Res.X + tileSize - 1) / tileSize;
+        unsigned int const tilesY = (options.Res.Y + tileSize - 1) / tileSize;
+        ThreadPool pool(options.Threads);
+        pool.ParallelFor(static_cast<std::size_t>(tilesX) * tilesY, 1, [&](std::size_t first, std::size_t last) {
+            RayBuffer rays;
+            std::vector<TraversalCost> primary;
+            std::vector<TraversalCost> secondary;
+            std::vector<unsigned int> secondaryRays;
+            for (std::size_t index = first; index < last; ++index) {
+                unsigned int const x = static_cast<unsigned int>(index % tilesX) * tileSize;
+                unsigned int const y = static_cast<unsigned int>(index / tilesX) * tileSize;
+                Tile const tile(x, y, std::min(tileSize, options.Res.X - x), std::min(tileSize, options.Res.Y - y));
+                camera.GenerateRays(tile, 0, rays);
+                primary.assign(rays.Size(), TraversalCost());
+                secondary.assign(rays.Size(), TraversalCost());
+                secondaryRays.assign(rays.Size(), 0);
+                engine.MeasureCost(rays, primary, secondary, secondaryRays);
+                for (std::size_t i = 0; i < rays.Size(); ++i) {
+                    PixelCost& cost = costs[(y + i / tile.Width) * options.Res.X + x + i % tile.Width];
+                    cost.Primary = primary[i];
+                    cost.Secondary = secondary[i];
+                    cost.SecondaryRays = secondaryRays[i];
+                }
+            }
+        });
+
+        TraversalCost primary;
+        TraversalCost secondary;
+        TraversalCost primaryPeak;
+        TraversalCost secondaryPeak;
+        std::size_t secondaryRays = 0;
+        std::vector<std::uint32_t> nodes(costs.size());
+        std::vector<std::uint32_t> triangles(costs.size());
+        for (std::size_t i = 0; i < costs.size(); ++i) {
+            primary += costs[i].Primary;
+            secondary += costs[i].Secondary;
+            secondaryRays += costs[i].SecondaryRays;
+            primaryPeak.Nodes = std::max(primaryPeak.Nodes, costs[i].Primary.Nodes);
+            primaryPeak.Triangles = std::max(primaryPeak.Triangles, costs[i].Primary.Triangles);
+            secondaryPeak.Nodes = std::max(secondaryPeak.Nodes, costs[i].Secondary.Nodes);
+            secondaryPeak.Triangles = std::max(secondaryPeak.Triangles, costs[i].Secondary.Triangles);
+            nodes[i] = costs[i].Primary.Nodes + costs[i].Secondary.Nodes;
+            triangles[i] = costs[i].Primary.Triangles + costs[i].Secondary.Triangles;
+        }
+        reportCost("Primary", primary, primaryPeak, costs.size(), std::cout);
+        reportCost(options.AO.Samples > 0 ? "Occlusion" : "Shadow", secondary, secondaryPeak, secondaryRays, std::cout);
+
+        // Red counts triangle tests and green node visits of all the pixel's rays, blue the node
+        // visits of its shadow or occlusion rays alone, each scaled to the 99th percentile
+        std::uint32_t const nodeScale = std::max(1u, percentile(nodes, HeatmapPercentile));
+        std::uint32_t const triangleScale = std::max(1u, percentile(triangles, HeatmapPercentile));
+        Image image(options.Res);
+        for (std::size_t i = 0; i < costs.size(); ++i) {
+            image.Pixels[i * 4] = scaleChannel(triangles[i], triangleScale);
+            image.Pixels[i * 4 + 1] = scaleChannel(nodes[i], nodeScale);
+            image.Pixels[i * 4 + 2] = scaleChannel(costs[i].Secondary.Nodes, nodeScale);
+        }
+        std::cout << "Heatmap: red " << triangleScale << " triangle tests, green " << nodeScale
+                  << " node visits, blue the shadow or occlusion part of the node visits" << std::endl;
+        ReportMemory(std::cout);
+        return image.WritePPM(options.Output) ? 0 : 1;
+    }
+}  // namespace rt
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Options.h"
+
+namespace rt {
+    int     RunCoordinator(Options const& options);
+    int     RunWorker(Options const& options);
+    int     RunServer(Options const& options);
+    int     RunClient(Options const& options);
+    int     RunBatch(Options const& options);
+    int     RunAnimation(Options const& options);
+    int     RunBvhReport(Options const& options);
+    int     RunHeatmap(Options const& options);
+    int     RunNumaReport(Options const& options);
+}  // namespace rt
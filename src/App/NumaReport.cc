@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include "../Engine/Engine.h"
+#include "../Engine/Memory.h"
+#include "../Engine/Numa.h"
+#include "../Loader/AssimpLoader.h"
+#include "../Render/Image.h"
+#include "../Render/ThreadPool.h"
+#include "../Render/TileRenderer.h"
+#include "Modes.h"
+
+namespace rt {
+    namespace {
+        // Frames traced per configuration, the fastest one counts
+        constexpr unsigned int NumaReportRuns = 5;
+
+        float bestFrame(TileRenderer& renderer, Camera const& camera, Options const& options) {
+            Image image(options.Res);
+            float best = std::numeric_limits<float>::max();
+            for (unsigned int run = 0; run < NumaReportRuns; ++run) {
+                auto const start = std::chrono::steady_clock::now();
+                renderer.Render(camera, Tile(0, 0, options.Res.X, options.Res.Y), options.Spp, image.Pixels.data(), image.GetStride());
+                best = std::min(best, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+            return best;
+        }
+    }
+
+    // Times the scene camera's view with one shared engine and unpinned workers, then with
+    // workers pinned per node and per-node copies, each with and without huge pages
+    int RunNumaReport(Options const& options) {
+        AssimpLoader loader;
+        loader.SetLodOptions(options.Lod);
+        std::cout << "Loading scene " << options.Scene << "..." << std::endl;
+        if (!loader.LoadFile(options.Scene)) {
+            return 1;
+        }
+        Scene const scene = loader.TakeScene();
+        scene.Report(std::cout);
+        std::vector<NumaNode> const nodes = ReadNumaTopology();
+        ReportNuma(nodes, std::cout);
+
+        HugePages const hugePages = options.HugePageMode == HugePages::Off ? HugePages::Transparent : options.HugePageMode;
+        float baseline = 0.f;
+        for (HugePages mode : {HugePages::Off, hugePages}) {
+            SetHugePages(mode);
+            Engine engine{Scene(scene), options.Accel};
+            engine.SetShading(GetShadingOptions(options));
+            Camera camera = *engine.GetCamera();
+            camera.SetFOV(options.FOV);
+            camera.SetRes(options.Res);
+            engine.SetLevelOfDetail(options.LodPixels * camera.GetPixelAngle());
+            std::cout << "Huge pages " << GetName(mode) << ":" << std::endl;
+            ReportMemory(std::cout);
+
+            for (bool numa : {false, true}) {
+                float milliseconds = 0.f;
+                if (numa) {
+                    EngineReplicas const replicas(engine, nodes, options.Threads);
+                    ThreadPool pool(options.Threads, [&replicas](unsigned int worker) {
+                        replicas.PinWorker(worker);
+                    });
+                    TileRenderer renderer(engine, pool);
+                    renderer.SetReplicas(&replicas);
+                    milliseconds = bestFrame(renderer, camera, options);
+                } else {
+                    ThreadPool pool(options.Threads);
+                    TileRenderer renderer(engine, pool);
+                    milliseconds = bestFrame(renderer, camera, options);
+                }
+                if (baseline == 0.f) {
+                    baseline = milliseconds;
+                }
+                std::cout << std::fixed << std::setprecision(2) << "    " << (numa ? "pinned, per-node copies" : "shared, unpinned")
+                          << ": " << milliseconds << " ms, " << baseline / milliseconds << "x shared without huge pages" << std::endl;
+            }
+        }
+        SetHugePages(options.HugePageMode);
+        ReportMemory(std::cout);
+        return 0;
+    }
+}  // namespace rt
@@ -0,0 +1,216 @@
+#include <cstdlib>
+#include "../Net/Message.h"
+#include "Options.h"
+
+namespace rt {
+    namespace {
+        bool parseAddress(std::string const& address, Options& options) {
+            std::size_t colon = address.rfind(':');
+            if (colon == std::string::npos) {
+                return false;
+            }
+            options.Host = address.substr(0, colon);
+            options.Port = static_cast<std::uint16_t>(std::strtoul(address.c_str() + colon + 1, nullptr, 10));
+            return true;
+        }
+
+        // Flags that decide how the engine builds and shades the scene. Workers take them from the
+        // coordinator's job and clients from the server, so those modes refuse them.
+        bool setsEngine(Options const& options) {
+            Options const defaults;
+            return options.Accel.Builder != defaults.Accel.Builder || options.Accel.Width != defaults.Accel.Width
+                || options.Accel.SpatialOverhead != defaults.Accel.SpatialOverhead || options.Shadows != defaults.Shadows
+                || options.OccluderCache != defaults.OccluderCache || options.TileCulling != defaults.TileCulling
+                || options.LightRadius != defaults.LightRadius || options.AO.Samples != defaults.AO.Samples
+                || options.AO.Distance != defaults.AO.Distance || options.LodPixels != defaults.LodPixels
+                || options.Lod.MinTriangles != defaults.Lod.MinTriangles;
+        }
+    }  // namespace
+
+    bool ParseOptions(int argc, char **argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--width" && hasValue) {
+                options.Res.X = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--height" && hasValue) {
+                options.Res.Y = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--fov" && hasValue) {
+                options.FOV = std::strtof(argv[++i], nullptr);
+            } else if (arg == "--fps" && hasValue) {
+                options.Fps = std::strtof(argv[++i], nullptr);
+            } else if (arg == "--target-ms" && hasValue) {
+                options.TargetFrameTime = std::strtof(argv[++i], nullptr);
+            } else if (arg == "--threads" && hasValue) {
+                options.Threads = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--spp" && hasValue) {
+                options.Spp = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--output" && hasValue) {
+                options.Output = argv[++i];
+            } else if (arg == "--coordinator" && hasValue) {
+                options.RunMode = Mode::Coordinator;
+                options.Port = static_cast<std::uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "--worker" && hasValue) {
+                options.RunMode = Mode::Worker;
+                if (!parseAddress(argv[++i], options)) {
+                    return false;
+                }
+            } else if (arg == "--server" && hasValue) {
+                options.RunMode = Mode::Server;
+                options.Port = static_cast<std::uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+            } else if (arg == "--cache" && hasValue) {
+                options.CacheSize = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--request" && hasValue) {
+                options.RunMode = Mode::Client;
+                if (!parseAddress(argv[++i], options)) {
+                    return false;
+                }
+            } else if (arg == "--batch" && hasValue) {
+                options.RunMode = Mode::Batch;
+                options.Poses = argv[++i];
+            } else if (arg == "--animate" && hasValue) {
+                options.RunMode = Mode::Animate;
+                options.Poses = argv[++i];
+            } else if (arg == "--frames" && hasValue) {
+                options.Frames = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--bvh" && hasValue) {
+                std::string builder = argv[++i];
+                if (builder == "sah") {
+                    options.Accel.Builder = BVHBuilder::BinnedSAH;
+                } else if (builder == "lbvh") {
+                    options.Accel.Builder = BVHBuilder::LBVH;
+                } else if (builder == "sbvh") {
+                    options.Accel.Builder = BVHBuilder::SBVH;
+                } else {
+                    return false;
+                }
+            } else if (arg == "--sbvh-overhead" && hasValue) {
+                options.Accel.SpatialOverhead = std::strtof(argv[++i], nullptr);
+                if (options.Accel.SpatialOverhead < 0.f) {
+                    return false;
+                }
+            } else if (arg == "--bvh-width" && hasValue) {
+                options.Accel.Width = std::strtoul(argv[++i], nullptr, 10);
+                if (options.Accel.Width != 2 && options.Accel.Width != 4 && options.Accel.Width != 8) {
+                    return false;
+                }
+            } else if (arg == "--bvh-report") {
+                options.RunMode = Mode::BvhReport;
+            } else if (arg == "--bvh-heatmap") {
+                options.RunMode = Mode::Heatmap;
+            } else if (arg == "--numa-report") {
+                options.RunMode = Mode::NumaReport;
+            } else if (arg == "--numa") {
+                options.Numa = true;
+            } else if (arg == "--huge-pages" && hasValue) {
+                std::string mode = argv[++i];
+                if (mode == "off") {
+                    options.HugePageMode = HugePages::Off;
+                } else if (mode == "thp") {
+                    options.HugePageMode = HugePages::Transparent;
+                } else if (mode == "explicit") {
+                    options.HugePageMode = HugePages::Explicit;
+                } else {
+                    return false;
+                }
+            } else if (arg == "--metrics") {
+                options.Metrics = true;
+            } else if (arg == "--shutdown") {
+                options.Shutdown = true;
+            } else if (arg == "--workers" && hasValue) {
+                options.Workers = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--tile" && hasValue) {
+                options.TileSize = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--ao" && hasValue) {
+                options.AO.Samples = std::strtoul(argv[++i], nullptr, 10);
+            } else if (arg == "--ao-distance" && hasValue) {
+                options.AO.Distance = std::strtof(argv[++i], nullptr);
+                if (options.AO.Distance <= 0.f) {
+                    return false;
+                }
+            } else if (arg == "--light-radius" && hasValue) {
+                options.LightRadius = std::strtof(argv[++i], nullptr);
+                if (options.LightRadius < 0.f) {
+                    return false;
+                }
+            } else if (arg == "--lod" && hasValue) {
+                options.LodPixels = std::strtof(argv[++i], nullptr);
+                if (options.LodPixels < 0.f) {
+                    return false;
+                }
+            } else if (arg == "--lod-min" && hasValue) {
+                options.Lod.MinTriangles = std::strtoul(argv[++i], nullptr, 10);
+                if (options.Lod.MinTriangles == 0) {
+                    return false;
+                }
+            } else if (arg == "--no-shadows") {
+                options.Shadows = false;
+            } else if (arg == "--no-occluder-cache") {
+                options.OccluderCache = false;
+            } else if (arg == "--no-tile-culling") {
+                options.TileCulling = false;
+            } else if (arg == "--raster") {
+                options.Rasterize = true;
+            } else if (arg == "--scaling") {
+                options.Scaling = true;
+            } else if (arg[0] != '-' && options.Scene.empty()) {
+                options.Scene = arg;
+            } else {
+                return false;
+            }
+        }
+        if ((options.RunMode == Mode::Worker || options.RunMode == Mode::Client) && setsEngine(options)) {
+            return false;
+        }
+        // Only batch renders pin workers and copy the engine per node
+        if (options.Numa && options.RunMode != Mode::Batch) {
+            return false;
+        }
+        // Cached scenes serve every view, so the server cannot pick levels per camera
+        if (options.RunMode == Mode::Server && (options.LodPixels > 0.f || options.Lod.MinTriangles != DefaultLodMinTriangles)) {
+            return false;
+        }
+        // Hierarchies are built on no more threads than the renders use
+        options.Accel.BuildThreads = options.Threads;
+        // Levels no ray would pick are not worth generating
+        if (options.LodPixels == 0.f) {
+            options.Lod.MinTriangles = 0;
+        }
+        if (options.RunMode == Mode::Worker || options.RunMode == Mode::Server) {
+            return options.Port != 0 && options.CacheSize > 0;
+        }
+        if (options.RunMode == Mode::Client && (options.Port == 0 || options.Metrics || options.Shutdown)) {
+            return options.Port != 0;
+        }
+        if (options.RunMode == Mode::Coordinator && (options.Port == 0 || options.Workers == 0 || options.TileSize == 0
+                                                     || std::size_t(options.TileSize) * options.TileSize > Message::MaxImagePixels)) {
+            return false;
+        }
+        return !options.Scene.empty() && options.Res.X > 0 && options.Res.Y > 0 && options.FOV > 0.f && options.FOV < 180.f
+            && options.Fps > 0.f && options.Spp > 0;
+    }
+
+    ShadingOptions GetShadingOptions(Options const& options) {
+        ShadingOptions shading;
+        shading.Shadows = options.Shadows;
+        shading.OccluderCache = options.OccluderCache;
+        shading.TileCulling = options.TileCulling;
+        shading.LightRadius = options.LightRadius;
+        shading.AO = options.AO;
+        return shading;
+    }
+
+    void PrintUsage(std::ostream& out, char const* program) {
+        out << "Usage: " << program << " scene.dae [--width W] [--height H] [--fov DEG] [--fps N] [--target-ms MS] [--threads N] [--bvh sah|lbvh|sbvh] [--sbvh-overhead X] [--bvh-width 2|4|8] [--no-shadows] [--no-occluder-cache] [--no-tile-culling] [--light-radius R] [--ao N] [--ao-distance D] [--lod PIXELS] [--lod-min N]" << std::endl
+            << "       " << program << " scene.dae --coordinator PORT [--workers N] [--spp N] [--tile N] [--output FILE.ppm] [--scaling] [--bvh sah|lbvh|sbvh] [--sbvh-overhead X] [--bvh-width 2|4|8] [--no-shadows] [--no-occluder-cache] [--no-tile-culling] [--light-radius R] [--ao N] [--ao-distance D] [--lod PIXELS] [--lod-min N]" << std::endl
+            << "       " << program << " --worker HOST:PORT [--threads N]" << std::endl
+            << "       " << program << " --server PORT [--threads N] [--cache SCENES] [--bvh sah|lbvh|sbvh] [--sbvh-overhead X] [--bvh-width 2|4|8] [--no-shadows] [--no-occluder-cache] [--no-tile-culling] [--light-radius R] [--ao N] [--ao-distance D]" << std::endl
+            << "       " << program << " scene.dae --request HOST:PORT [--width W] [--height H] [--fov DEG] [--spp N] [--output FILE.ppm]" << std::endl
+            << "       " << program << " --request HOST:PORT --metrics | --shutdown" << std::endl
+            << "       " << program << " scene.dae --batch POSES.txt [--numa] [--huge-pages off|thp|explicit] [--width W] [--height H] [--fov DEG] [--spp N] [--threads N] [--no-shadows] [--no-occluder-cache] [--no-tile-culling] [--raster] [--light-radius R] [--ao N] [--ao-distance D] [--lod PIXELS] [--lod-min N] [--output FILE.ppm]" << std::endl
+            << "       " << program << " scene.dae --animate demo|KEYS.txt [--frames N] [--fps N] [--width W] [--height H] [--spp N] [--no-shadows] [--no-occluder-cache] [--no-tile-culling] [--raster] [--light-radius R] [--ao N] [--ao-distance D] [--lod PIXELS] [--lod-min N] [--output FILE.y4m|FILE.ppm]" << std::endl
+            << "       " << program << " scene.dae --bvh-report [--width W] [--height H] [--spp N] [--threads N]" << std::endl
+            << "       " << program << " scene.dae --bvh-heatmap [--bvh sah|lbvh|sbvh] [--bvh-width 2|4|8] [--width W] [--height H] [--threads N] [--no-shadows] [--no-occluder-cache] [--no-tile-culling] [--light-radius R] [--ao N] [--lod PIXELS] [--lod-min N] [--output FILE.ppm]" << std::endl
+            << "       " << program << " scene.dae --numa-report [--huge-pages thp|explicit] [--lod PIXELS] [--lod-min N] [--width W] [--height H] [--spp N] [--threads N]" << std::endl;
+    }
+}  // namespace rt
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include "../Accel/BVH.h"
+#include "../Engine/Engine.h"
+#include "../Engine/Memory.h"
+#include "../Engine/Constant.h"
+#include "../Render/FrameBudget.h"
+#include "../Vector/Vector2.h"
+
+namespace rt {
+    enum class Mode {
+        Interactive,
+        Coordinator,
+        Worker,
+        Server,
+        Client,
+        Batch,
+        Animate,
+        BvhReport,
+        Heatmap,
+        NumaReport
+    };
+
+    // Objects below this many triangles are cheap enough at full detail
+    constexpr std::uint32_t DefaultLodMinTriangles = 1024;
+
+    struct Options {
+        Mode                    RunMode = Mode::Interactive;
+        std::string             Scene;
+        Vector2<unsigned int>   Res{Constant::DefaultScreenWidth, Constant::DefaultScreenHeight};
+        float                   FOV = Constant::DefaultScreenFOV;
+        float                   TargetFrameTime = 0.f;
+        float                   Fps = FrameBudget::DefaultFps;
+        unsigned int            Threads = std::thread::hardware_concurrency();
+        unsigned int            Spp = 1;
+        std::string             Output = "render.ppm";
+        std::string             Host;
+        std::uint16_t           Port = 0;
+        unsigned int            Workers = 1;
+        unsigned int            TileSize = 64;
+        bool                    Scaling = false;
+        std::size_t             CacheSize = 4;
+        bool                    Metrics = false;
+        bool                    Shutdown = false;
+        std::string             Poses;
+        std::size_t             Frames = 0;
+        AccelOptions            Accel;
+        bool                    Shadows = true;
+        bool                    OccluderCache = true;
+        bool                    TileCulling = true;
+        // Batch and animation only: camera rays start from a rasterized visibility buffer
+        bool                    Rasterize = false;
+        // Cutoff radius forced on every light, 0 keeps the radii derived from their attenuation
+        float                   LightRadius = 0.f;
+        AOOptions               AO;
+        // Simplification error allowed in pixels, 0 traces full meshes and generates no levels
+        float                   LodPixels = 0.f;
+        LodOptions              Lod{DefaultLodMinTriangles};
+        // Pins workers per NUMA node and gives each node its own copy of the scene
+        bool                    Numa = false;
+        HugePages               HugePageMode = HugePages::Off;
+    };
+
+    bool            ParseOptions(int argc, char **argv, Options& options);
+    ShadingOptions  GetShadingOptions(Options const& options);
+    void            PrintUsage(std::ostream& out, char const* program);
+}  // namespace rt
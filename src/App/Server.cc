@@ -0,0 +1,62 @@
+#include <iomanip>
+#include <iostream>
+#include "../Server/RenderServer.h"
+#include "../Server/ServerProtocol.h"
+#include "Modes.h"
+
+namespace rt {
+    int RunServer(Options const& options) {
+        RenderServer server(options.Threads, options.CacheSize, options.Accel, GetShadingOptions(options));
+        if (!server.Listen(options.Port)) {
+            return 1;
+        }
+        std::cout << "Render server listening on 127.0.0.1:" << options.Port << ", caching up to "
+                  << options.CacheSize << " scene(s)" << std::endl;
+        server.Run();
+        server.Report(std::cout);
+        return 0;
+    }
+
+    int RunClient(Options const& options) {
+        Socket link;
+        if (!link.Connect(options.Host, options.Port)) {
+            std::cerr << "Cannot connect to " << options.Host << ":" << options.Port << std::endl;
+            return 1;
+        }
+        if (options.Metrics || options.Shutdown) {
+            Message reply;
+            std::string report;
+            ServerMessage const query = options.Shutdown ? ServerMessage::Shutdown : ServerMessage::Metrics;
+            if (!Message(static_cast<std::uint8_t>(query)).Send(link) || !reply.Receive(link)
+                || reply.GetType() != static_cast<std::uint8_t>(ServerMessage::MetricsReport) || !reply.ReadString(report)) {
+                std::cerr << "No metrics from server" << std::endl;
+                return 1;
+            }
+            std::cout << report;
+            return 0;
+        }
+
+        RenderRequest request;
+        request.ScenePath = options.Scene;
+        request.Res = options.Res;
+        request.FOV = options.FOV;
+        request.Spp = options.Spp;
+        Message message(static_cast<std::uint8_t>(ServerMessage::Render));
+        WriteRequest(message, request);
+        Message reply;
+        if (!message.Send(link) || !reply.Receive(link)) {
+            std::cerr << "Connection to server lost" << std::endl;
+            return 1;
+        }
+        RenderReply result;
+        if (reply.GetType() != static_cast<std::uint8_t>(ServerMessage::Result) || !ReadReply(reply, result)) {
+            std::string error = "malformed reply";
+            reply.ReadString(error);
+            std::cerr << "Render failed: " << error << std::endl;
+            return 1;
+        }
+        std::cout << std::fixed << std::setprecision(2) << "queued " << result.QueueTime << " ms, rendered "
+                  << result.RenderTime << " ms, scene " << (result.CacheHit ? "cached" : "loaded") << std::endl;
+        return result.Picture.WritePPM(options.Output) ? 0 : 1;
+    }
+}  // namespace rt
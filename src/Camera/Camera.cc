@@ -1,11 +1,17 @@
 #include <cstdlib>
+#include <algorithm>
 #include <cmath>
 #include "Camera.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RT_CAMERA_SSE
+#endif
 #include "../Engine/Constant.h"
 
 namespace rt {
     Camera::Camera(): _pos(Vector3<float>(0, 0, 0)), _c1(Vector3<float>(1, 0, 0)),
         _c2(Vector3<float>(0, 1, 0)), _c3(Vector3<float>(0, 0, 1)),
+        _screenRes(Constant::DefaultScreenWidth, Constant::DefaultScreenHeight), _fov(Constant::DefaultScreenFOV),
         _gen(std::random_device()()), _dis(0.f, 1.f) {
         generateScreen();
     }
@@ -24,6 +30,78 @@ namespace rt {
         return ray;
     }
 
+    Vector2<float> Camera::GetSampleOffset(unsigned int sampleIndex) const {
+        #ifndef RT_TESTING_ENV
+        // R2 low-discrepancy sequence, one sub-pixel offset per sample index
+        return Vector2<float>(std::fmod(0.5f + 0.7548776662f * sampleIndex, 1.f), std::fmod(0.5f + 0.5698402910f * sampleIndex, 1.f));
+        #else
+        (void)sampleIndex;
+        return Vector2<float>(0.0f, 0.0f);
+        #endif
+    }
+
+    Vector3<float> Camera::Project(Vector3<float> const& point) const {
+        Vector3<float> const offset = point - _pos;
+        float const z = _projectZ.Dot(offset);
+        return Vector3<float>(_projectX.Dot(offset) / z, _projectY.Dot(offset) / z, z);
+    }
+
+    Vector3<float> const& Camera::GetPixelDX(void) const {
+        return _pixelDX;
+    }
+
+    Vector3<float> const& Camera::GetPixelDY(void) const {
+        return _pixelDY;
+    }
+
+    Vector3<float> Camera::GetCornerDirection(void) const {
+        return _screenCorner - _pos;
+    }
+
+    void Camera::GenerateRays(Tile const& tile, unsigned int sampleIndex, RayBuffer& rays) const {
+        Vector2<float> const sample = GetSampleOffset(sampleIndex);
+        float const Rx = sample.X;
+        float const Ry = sample.Y;
+        rays.Resize(tile);
+        std::size_t const count = rays.Size();
+        std::fill(rays.OriginX.begin(), rays.OriginX.end(), _pos.X);
+        std::fill(rays.OriginY.begin(), rays.OriginY.end(), _pos.Y);
+        std::fill(rays.OriginZ.begin(), rays.OriginZ.end(), _pos.Z);
+
+        float* dirX = rays.DirectionX.data();
+        float* dirY = rays.DirectionY.data();
+        float* dirZ = rays.DirectionZ.data();
+        Vector3<float> const start = _screenCorner - _pos + _pixelDX * (tile.X + Rx) + _pixelDY * (tile.Y + Ry);
+        for (unsigned int row = 0; row < tile.Height; ++row) {
+            Vector3<float> const rowStart = start + _pixelDY * static_cast<float>(row);
+            std::size_t const offset = static_cast<std::size_t>(row) * tile.Width;
+            for (unsigned int col = 0; col < tile.Width; ++col) {
+                dirX[offset + col] = rowStart.X + _pixelDX.X * col;
+                dirY[offset + col] = rowStart.Y + _pixelDX.Y * col;
+                dirZ[offset + col] = rowStart.Z + _pixelDX.Z * col;
+            }
+        }
+
+        std::size_t i = 0;
+        #ifdef RT_CAMERA_SSE
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(dirX + i);
+            __m128 y = _mm_loadu_ps(dirY + i);
+            __m128 z = _mm_loadu_ps(dirZ + i);
+            __m128 norm = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+            _mm_storeu_ps(dirX + i, _mm_div_ps(x, norm));
+            _mm_storeu_ps(dirY + i, _mm_div_ps(y, norm));
+            _mm_storeu_ps(dirZ + i, _mm_div_ps(z, norm));
+        }
+        #endif
+        for (; i < count; ++i) {
+            float norm = std::sqrt(dirX[i] * dirX[i] + dirY[i] * dirY[i] + dirZ[i] * dirZ[i]);
+            dirX[i] /= norm;
+            dirY[i] /= norm;
+            dirZ[i] /= norm;
+        }
+    }
+
     Vector3<float> const& Camera::GetPos(void) const {
         return _pos;
     }
@@ -72,6 +150,25 @@ namespace rt {
         return _screenRes;
     }
 
+    void Camera::SetRes(Vector2<unsigned int> const& res) {
+        _screenRes = res;
+        generateScreen();
+    }
+
+    float Camera::GetFOV(void) const {
+        return _fov;
+    }
+
+    void Camera::SetFOV(float fov) {
+        _fov = fov;
+        generateScreen();
+    }
+
+    // The screen lies at unit distance along -c3
+    float Camera::GetPixelAngle(void) const {
+        return _screenSize.X / _screenRes.X;
+    }
+
    void Camera::SetMatrix(Vector3<float> const& c1, Vector3<float> const& c2,
         Vector3<float> const& c3, Vector3<float> const& pos) {
             _c1 = c1;
@@ -81,11 +178,26 @@ namespace rt {
             generateScreen();
     }
 
+   CameraPose Camera::GetPose(void) const {
+        return CameraPose{_pos, _c1, _c2, _c3};
+   }
+
+   void Camera::SetPose(CameraPose const& pose) {
+        SetMatrix(pose.C1, pose.C2, pose.C3, pose.Pos);
+   }
+
    void Camera::generateScreen() {
         _screenDist = 0.5f;
-        _screenRes = Vector2<unsigned int>(Constant::DefaultScreenWidth, Constant::DefaultScreenHeight);
-        float screenWidth = 2.f * std::tan((Constant::DefaultScreenFOV / 2.f) * static_cast<float>(Constant::PI) / 180.f) * _screenDist;
+        float screenWidth = 2.f * std::tan((_fov / 2.f) * static_cast<float>(Constant::PI) / 180.f) * _screenDist;
         _screenSize = Vector2<float>(screenWidth, screenWidth * _screenRes.Y / _screenRes.X);
         _screenCorner = _pos + _c3 * (-1.f) - _c1 * (_screenSize.X / 2.f) + _c2 * (_screenSize.Y / 2.f);
+        _pixelDX = _c1 * (_screenSize.X / _screenRes.X);
+        _pixelDY = _c2 * (-_screenSize.Y / _screenRes.Y);
+        // Direction = _pixelDX * x + _pixelDY * y + corner, inverted by Cramer's rule
+        Vector3<float> const corner = _screenCorner - _pos;
+        float const det = _pixelDX.Dot(_pixelDY.Cross(corner));
+        _projectX = _pixelDY.Cross(corner) / det;
+        _projectY = corner.Cross(_pixelDX) / det;
+        _projectZ = _pixelDX.Cross(_pixelDY) / det;
    }
 }  // namespace rt
@@ -5,13 +5,33 @@
 #include "../Vector/Vector3.h"
 #include "../Vector/Vector2.h"
 #include "../Engine/Tools.h"
+#include "RayBuffer.h"
 
 namespace rt {
+struct CameraPose {
+   Vector3<float>  Pos;
+   Vector3<float>  C1;
+   Vector3<float>  C2;
+   Vector3<float>  C3;
+};
+
 class Camera {
  public:
    Camera();
 
    Ray const  GenerateRay(Vector2<unsigned int> const &pos);
+   void       GenerateRays(Tile const& tile, unsigned int sampleIndex, RayBuffer& rays) const;
+   // Sub-pixel position of the rays GenerateRays traces for sampleIndex
+   Vector2<float>                         GetSampleOffset(unsigned int sampleIndex) const;
+   // Continuous pixel coordinates of point, where the ray GenerateRays traces for pixel (x, y)
+   // passes (x + offset.X, y + offset.Y), and in Z the point's distance along that ray over the
+   // length of its direction before normalization. Z is not positive behind the camera.
+   Vector3<float>                         Project(Vector3<float> const& point) const;
+   // GenerateRays traces the direction GetPixelDX() * x + GetPixelDY() * y + GetCornerDirection()
+   // through the continuous pixel coordinates (x, y)
+   Vector3<float> const&                  GetPixelDX(void) const;
+   Vector3<float> const&                  GetPixelDY(void) const;
+   Vector3<float>                         GetCornerDirection(void) const;
    
    Vector3<float> const&                  GetPos(void) const;
 
@@ -24,7 +44,15 @@ class Camera {
    void                                   TurnRight(void);
 
    Vector2<unsigned int> const&           GetRes(void) const;
+   void                                   SetRes(Vector2<unsigned int> const& res);
+   float                                  GetFOV(void) const;
+   void                                   SetFOV(float fov);
+   // Angle between neighbouring pixels at the centre of the screen, in radians
+   float                                  GetPixelAngle(void) const;
    void                                   SetMatrix(Vector3<float> const& pos, Vector3<float> const& c1, Vector3<float> const& c2, Vector3<float> const& c3);
+
+   CameraPose                             GetPose(void) const;
+   void                                   SetPose(CameraPose const& pose);
  
  private:
    Vector3<float>                         _pos;
@@ -34,7 +62,14 @@ class Camera {
    Vector2<unsigned int>                  _screenRes;
    Vector2<float>                         _screenSize;
    Vector3<float>                         _screenCorner;
+   Vector3<float>                         _pixelDX;
+   Vector3<float>                         _pixelDY;
+   // Rows of the inverse of the matrix taking (x, y, 1) to a ray direction
+   Vector3<float>                         _projectX;
+   Vector3<float>                         _projectY;
+   Vector3<float>                         _projectZ;
    float                                  _screenDist;
+   float                                  _fov;
    std::mt19937                           _gen;
    std::uniform_real_distribution<float>  _dis;
 
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <utility>
+#include "CameraPath.h"
+
+namespace rt {
+    namespace {
+        Vector3<float> lerp(Vector3<float> const& a, Vector3<float> const& b, float t) {
+            return a + (b - a) * t;
+        }
+
+        Vector3<float> orthogonalize(Vector3<float> v, Vector3<float> const& a) {
+            v = v - a * v.Dot(a);
+            v.Normalize();
+            return v;
+        }
+    }
+
+    CameraPath::CameraPath(std::vector<CameraPose> poses) : _poses(std::move(poses)) {
+    }
+
+    CameraPath CameraPath::Demo(Camera const& start, std::size_t frameCount) {
+        Camera camera = start;
+        std::vector<CameraPose> poses;
+        for (std::size_t move = 0; move < frameCount; ++move) {
+            StepDemo(camera, move);
+            poses.push_back(camera.GetPose());
+        }
+        return CameraPath(std::move(poses));
+    }
+
+    void CameraPath::StepDemo(Camera& camera, std::size_t move) {
+        // The interactive Demo steps every fifth call of a 400-call cycle, turning
+        // left for the first and last quarter of it and right in between
+        std::size_t const counter = (move % DemoMoves) * 5 + 1;
+        if (counter < 100 || counter > 300) {
+            camera.TurnLeft();
+            camera.MoveRight();
+            camera.MoveRight();
+            camera.MoveRight();
+        } else {
+            camera.TurnRight();
+            camera.MoveLeft();
+            camera.MoveLeft();
+            camera.MoveLeft();
+        }
+    }
+
+    CameraPath CameraPath::Interpolate(std::vector<CameraPose> const& keys, std::size_t frameCount) {
+        if (keys.size() < 2 || frameCount < 2) {
+            return CameraPath(keys);
+        }
+        std::vector<CameraPose> poses;
+        float const step = static_cast<float>(keys.size() - 1) / (frameCount - 1);
+        for (std::size_t frame = 0; frame < frameCount; ++frame) {
+            float const position = frame * step;
+            std::size_t const key = std::min(static_cast<std::size_t>(position), keys.size() - 2);
+            float const t = position - key;
+            CameraPose const& a = keys[key];
+            CameraPose const& b = keys[key + 1];
+            CameraPose pose;
+            pose.Pos = lerp(a.Pos, b.Pos, t);
+            // Blended bases are no longer orthonormal, Gram-Schmidt them back from the view direction
+            pose.C3 = lerp(a.C3, b.C3, t);
+            pose.C3.Normalize();
+            pose.C1 = orthogonalize(lerp(a.C1, b.C1, t), pose.C3);
+            pose.C2 = orthogonalize(orthogonalize(lerp(a.C2, b.C2, t), pose.C3), pose.C1);
+            poses.push_back(pose);
+        }
+        return CameraPath(std::move(poses));
+    }
+
+    std::size_t CameraPath::GetFrameCount() const {
+        return _poses.size();
+    }
+
+    CameraPose const& CameraPath::GetPose(std::size_t frame) const {
+        return _poses[frame % _poses.size()];
+    }
+}  // namespace rt
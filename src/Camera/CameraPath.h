@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Camera.h"
+
+namespace rt {
+    // A sequence of camera poses, one per animation frame.
+    class CameraPath {
+    public:
+        CameraPath() {};
+        explicit    CameraPath(std::vector<CameraPose> poses);
+
+        // The Demo fly-through starting from the camera's pose, one loop unless more frames are asked for
+        static CameraPath   Demo(Camera const& start, std::size_t frameCount = DemoMoves);
+        // Samples frameCount poses evenly along the keyframes, blending linearly between neighbours
+        static CameraPath   Interpolate(std::vector<CameraPose> const& keys, std::size_t frameCount);
+        // Applies the Demo's n-th move to the camera
+        static void         StepDemo(Camera& camera, std::size_t move);
+
+        std::size_t         GetFrameCount() const;
+        CameraPose const&   GetPose(std::size_t frame) const;
+
+        static constexpr std::size_t DemoMoves = 81;
+
+    private:
+        std::vector<CameraPose>     _poses;
+    };
+}  // namespace rt
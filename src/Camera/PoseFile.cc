@@ -0,0 +1,31 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "PoseFile.h"
+
+namespace rt {
+    bool ReadPoses(std::string const& path, std::vector<CameraPose>& poses) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Cannot open pose file " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        for (unsigned int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+            std::size_t const start = line.find_first_not_of(" \t\r");
+            if (start == std::string::npos || line[start] == '#') {
+                continue;
+            }
+            std::istringstream fields(line);
+            CameraPose pose;
+            std::string rest;
+            if (!(fields >> pose.Pos.X >> pose.Pos.Y >> pose.Pos.Z >> pose.C1.X >> pose.C1.Y >> pose.C1.Z
+                         >> pose.C2.X >> pose.C2.Y >> pose.C2.Z >> pose.C3.X >> pose.C3.Y >> pose.C3.Z) || (fields >> rest)) {
+                std::cerr << path << ":" << lineNumber << ": expected 12 numbers (position, c1, c2, c3)" << std::endl;
+                return false;
+            }
+            poses.push_back(pose);
+        }
+        return true;
+    }
+}  // namespace rt
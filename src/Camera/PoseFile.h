@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Camera.h"
+
+namespace rt {
+    // One pose per line: position, then the c1, c2 and c3 basis vectors as passed to
+    // Camera::SetMatrix, twelve numbers in all. Blank lines and lines starting with '#' are skipped.
+    bool    ReadPoses(std::string const& path, std::vector<CameraPose>& poses);
+}  // namespace rt
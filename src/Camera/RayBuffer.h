@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "../Engine/Tools.h"
+#include "../Vector/Vector3.h"
+
+namespace rt {
+    // Structure-of-arrays batch of rays for one tile, stored row-major inside the tile.
+    struct RayBuffer {
+        Tile                Region;
+        std::vector<float>  OriginX;
+        std::vector<float>  OriginY;
+        std::vector<float>  OriginZ;
+        std::vector<float>  DirectionX;
+        std::vector<float>  DirectionY;
+        std::vector<float>  DirectionZ;
+
+        void    Resize(Tile const& region) {
+            std::size_t count = static_cast<std::size_t>(region.Width) * region.Height;
+            Region = region;
+            OriginX.resize(count);
+            OriginY.resize(count);
+            OriginZ.resize(count);
+            DirectionX.resize(count);
+            DirectionY.resize(count);
+            DirectionZ.resize(count);
+        }
+
+        std::size_t     Size() const {
+            return DirectionX.size();
+        }
+
+        Ray     GetRay(std::size_t i) const {
+            return Ray(Vector3<float>(OriginX[i], OriginY[i], OriginZ[i]),
+                       Vector3<float>(DirectionX[i], DirectionY[i], DirectionZ[i]));
+        }
+    };
+}  // namespace rt
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "Coordinator.h"
+
+namespace rt {
+    Coordinator::Coordinator(RenderJob const& job, unsigned int tileSize) : _job(job), _tileSize(tileSize) {
+    }
+
+    bool Coordinator::Listen(std::uint16_t port) {
+        if (!_listener.Listen(port)) {
+            std::cerr << "Cannot listen on port " << port << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool Coordinator::WaitForWorkers(std::size_t count) {
+        std::vector<std::unique_ptr<Connection>> joining;
+        while (joining.size() < count) {
+            auto connection = std::make_unique<Connection>();
+            connection->Link = _listener.Accept();
+            Message hello;
+            std::uint32_t threads = 0;
+            if (!connection->Link.IsValid() || !hello.Receive(connection->Link)
+                || hello.GetType() != static_cast<std::uint8_t>(MessageType::Hello) || !hello.Read(threads)) {
+                continue;
+            }
+            connection->Name = "worker " + std::to_string(_workers.size() + joining.size() + 1) + " (" + std::to_string(threads) + " threads)";
+            Message scene(static_cast<std::uint8_t>(MessageType::Scene));
+            WriteJob(scene, _job);
+            if (scene.Send(connection->Link)) {
+                std::cout << "Worker " << connection->Name << " connected, loading scene" << std::endl;
+                joining.push_back(std::move(connection));
+            }
+        }
+        for (auto& connection : joining) {
+            Message reply;
+            if (!reply.Receive(connection->Link) || reply.GetType() != static_cast<std::uint8_t>(MessageType::Ready)) {
+                std::string error = "connection lost";
+                reply.ReadString(error);
+                std::cerr << "Worker " << connection->Name << " failed: " << error << std::endl;
+                continue;
+            }
+            _workers.push_back(std::move(connection));
+        }
+        return _workers.size() == count;
+    }
+
+    bool Coordinator::Render(std::size_t workerCount, Image& image, ClusterRun& run) {
+        // Results of tiles another worker delivered first are discarded before the clock starts
+        for (auto& connection : _workers) {
+            Message late;
+            if (connection->Late && (!late.Receive(connection->Link)
+                                     || late.GetType() != static_cast<std::uint8_t>(MessageType::TileResult))) {
+                std::cerr << "Lost worker " << connection->Name << std::endl;
+                connection->Link.Close();
+            }
+            connection->Late = false;
+        }
+        _dropLost();
+        workerCount = std::min(workerCount, _workers.size());
+        image = Image(_job.Res);
+        TileScheduler scheduler(_job.Res, _tileSize);
+        run = ClusterRun();
+        run.Workers = workerCount;
+        run.Stats.resize(workerCount);
+
+        auto const start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < workerCount; ++i) {
+            threads.emplace_back(&Coordinator::_serve, this, std::ref(*_workers[i]), std::ref(scheduler),
+                                 std::ref(image), std::ref(run.Stats[i]));
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        run.WallTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        run.Reissued = scheduler.GetReissued();
+        _dropLost();
+
+        std::size_t completed = 0;
+        for (auto const& stats : run.Stats) {
+            completed += stats.Tiles;
+        }
+        return completed == scheduler.GetTileCount();
+    }
+
+    void Coordinator::_serve(Connection& connection, TileScheduler& scheduler, Image& image, WorkerStats& stats) {
+        stats.Name = connection.Name;
+        std::size_t tile = 0;
+        std::vector<std::uint8_t> pixels;
+        auto drop = [&](char const* reason) {
+            std::cerr << reason << " " << connection.Name << std::endl;
+            connection.Link.Close();
+            scheduler.Release(tile);
+        };
+        while (scheduler.Next(tile)) {
+            Tile const& rect = scheduler.GetTile(tile);
+            Message request(static_cast<std::uint8_t>(MessageType::Tile));
+            request.Write(static_cast<std::uint32_t>(tile)).Write(rect);
+            if (!request.Send(connection.Link)) {
+                return drop("Lost worker");
+            }
+            while (!connection.Link.WaitReadable(PollInterval)) {
+                if (scheduler.IsFinished()) {
+                    // Another worker delivered this tile. The next run discards the reply before it starts.
+                    connection.Late = true;
+                    return;
+                }
+            }
+            Message result;
+            std::uint32_t id = 0;
+            float renderTime = 0.f;
+            pixels.resize(static_cast<std::size_t>(rect.Width) * rect.Height * 4);
+            if (!result.Receive(connection.Link) || result.GetType() != static_cast<std::uint8_t>(MessageType::TileResult)
+                || !result.Read(id) || id != tile || !result.Read(renderTime) || !result.ReadBytes(pixels.data(), pixels.size())) {
+                return drop("Lost worker");
+            }
+            stats.BusyTime += renderTime;
+            if (scheduler.Complete(tile)) {
+                image.SetTile(rect, pixels.data());
+                ++stats.Tiles;
+            }
+        }
+    }
+
+    // Lost workers leave, so later runs only count the ones still connected
+    void Coordinator::_dropLost() {
+        _workers.erase(std::remove_if(_workers.begin(), _workers.end(), [](std::unique_ptr<Connection> const& connection) {
+            return !connection->Link.IsValid();
+        }), _workers.end());
+    }
+
+    void Coordinator::Shutdown() {
+        Message done(static_cast<std::uint8_t>(MessageType::Done));
+        for (auto& connection : _workers) {
+            if (connection->Link.IsValid()) {
+                done.Send(connection->Link);
+            }
+        }
+        _workers.clear();
+    }
+
+    void Coordinator::Report(std::vector<ClusterRun> const& runs, std::ostream& out) {
+        out << std::fixed << std::setprecision(2);
+        for (auto const& run : runs) {
+            out << run.Workers << " worker(s): " << run.WallTime << " ms, " << run.Reissued << " tile(s) re-issued" << std::endl;
+            for (auto const& stats : run.Stats) {
+                out << "    " << std::setw(24) << std::left << stats.Name << std::right << std::setw(6) << stats.Tiles
+                    << " tiles, busy " << stats.BusyTime << " ms (" << 100.f * stats.BusyTime / run.WallTime << "%)" << std::endl;
+            }
+        }
+        if (runs.size() < 2 || runs.front().Workers != 1) {
+            return;
+        }
+        // Efficiency of N workers: T(1) / (N * T(N)); the gain column is T(N-1) / T(N)
+        float const single = runs.front().WallTime;
+        out << "workers   speedup   efficiency   gain of last worker" << std::endl;
+        for (std::size_t i = 0; i < runs.size(); ++i) {
+            float const speedup = single / runs[i].WallTime;
+            float const gain = i > 0 ? runs[i - 1].WallTime / runs[i].WallTime : 1.f;
+            out << std::setw(7) << runs[i].Workers << std::setw(10) << speedup << std::setw(12) << 100.f * speedup / runs[i].Workers
+                << "%" << std::setw(21) << gain << std::endl;
+        }
+    }
+}  // namespace rt
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../Net/Socket.h"
+#include "../Render/Image.h"
+#include "Protocol.h"
+#include "TileScheduler.h"
+
+namespace rt {
+    struct WorkerStats {
+        std::string     Name;
+        std::size_t     Tiles = 0;
+        float           BusyTime = 0.f;
+    };
+
+    struct ClusterRun {
+        std::size_t                 Workers = 0;
+        float                       WallTime = 0.f;
+        std::size_t                 Reissued = 0;
+        std::vector<WorkerStats>    Stats;
+    };
+
+    // Ships a RenderJob to connected workers, hands out tiles and reassembles the image.
+    class Coordinator {
+    public:
+        Coordinator(RenderJob const& job, unsigned int tileSize);
+
+        bool    Listen(std::uint16_t port);
+        bool    WaitForWorkers(std::size_t count);
+        bool    Render(std::size_t workerCount, Image& image, ClusterRun& run);
+        void    Shutdown();
+
+        static void     Report(std::vector<ClusterRun> const& runs, std::ostream& out);
+
+        static constexpr int PollInterval = 100;
+
+    private:
+        struct Connection {
+            Socket          Link;
+            std::string     Name;
+            // A tile another worker delivered first is still being rendered, its result is discarded
+            bool            Late = false;
+        };
+
+        RenderJob                                   _job;
+        unsigned int                                _tileSize;
+        Socket                                      _listener;
+        std::vector<std::unique_ptr<Connection>>    _workers;
+
+        void    _serve(Connection& connection, TileScheduler& scheduler, Image& image, WorkerStats& stats);
+        void    _dropLost();
+    };
+}  // namespace rt
@@ -0,0 +1,34 @@
+#include <fstream>
+#include <vector>
+#include "Protocol.h"
+
+namespace rt {
+    void WriteJob(Message& message, RenderJob const& job) {
+        message.WriteString(job.ScenePath);
+        message.Write(job.SceneHash).Write(job.Pose).Write(job.Res).Write(job.FOV).Write(job.Spp);
+        message.Write(job.Accel).Write(job.Shading).Write(job.Lod).Write(job.LodPixels);
+    }
+
+    bool ReadJob(Message& message, RenderJob& job) {
+        return message.ReadString(job.ScenePath) && message.Read(job.SceneHash) && message.Read(job.Pose)
+            && message.Read(job.Res) && message.Read(job.FOV) && message.Read(job.Spp) && message.Read(job.Accel)
+            && message.Read(job.Shading) && message.Read(job.Lod) && message.Read(job.LodPixels);
+    }
+
+    std::uint64_t HashFile(std::string const& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return 0;
+        }
+        // 64-bit FNV-1a
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        std::vector<char> buffer(1 << 16);
+        while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+            for (std::streamsize i = 0; i < in.gcount(); ++i) {
+                hash ^= static_cast<std::uint8_t>(buffer[i]);
+                hash *= 0x100000001b3ull;
+            }
+        }
+        return hash;
+    }
+}  // namespace rt
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "../Camera/Camera.h"
+#include "../Engine/Engine.h"
+#include "../Net/Message.h"
+#include "../Vector/Vector2.h"
+
+namespace rt {
+    enum class MessageType : std::uint8_t {
+        Hello = 1,
+        Scene,
+        Ready,
+        Tile,
+        TileResult,
+        Done,
+        Error
+    };
+
+    // Everything a worker needs to reproduce the coordinator's view of the scene.
+    // The scene itself is not shipped: workers load ScenePath and check it against SceneHash.
+    struct RenderJob {
+        std::string             ScenePath;
+        std::uint64_t           SceneHash = 0;
+        CameraPose              Pose;
+        Vector2<unsigned int>   Res;
+        float                   FOV = 0.f;
+        std::uint32_t           Spp = 1;
+        // Workers build with their own thread count whatever Accel.BuildThreads says
+        AccelOptions            Accel;
+        ShadingOptions          Shading;
+        LodOptions              Lod;
+        // Simplification error allowed in pixels, 0 traces full meshes
+        float                   LodPixels = 0.f;
+    };
+
+    void            WriteJob(Message& message, RenderJob const& job);
+    bool            ReadJob(Message& message, RenderJob& job);
+    std::uint64_t   HashFile(std::string const& path);
+}  // namespace rt
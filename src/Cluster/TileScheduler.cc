@@ -0,0 +1,105 @@
+#include <algorithm>
+#include "TileScheduler.h"
+
+namespace rt {
+    TileScheduler::TileScheduler(Vector2<unsigned int> const& res, unsigned int tileSize) : _reissued(0) {
+        for (unsigned int y = 0; y < res.Y; y += tileSize) {
+            for (unsigned int x = 0; x < res.X; x += tileSize) {
+                _pending.push_back(_tiles.size());
+                _tiles.emplace_back(x, y, std::min(tileSize, res.X - x), std::min(tileSize, res.Y - y));
+            }
+        }
+        _states.resize(_tiles.size());
+        _remaining = _tiles.size();
+    }
+
+    bool TileScheduler::Next(std::size_t& tile) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_remaining > 0) {
+            if (!_pending.empty()) {
+                tile = _pending.front();
+                _pending.pop_front();
+            } else if (!_findStraggler(tile)) {
+                _cv.wait_for(lock, std::chrono::milliseconds(20));
+                continue;
+            }
+            if (_states[tile].Outstanding++ == 0) {
+                _states[tile].IssuedAt = std::chrono::steady_clock::now();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool TileScheduler::Complete(std::size_t tile) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        TileState& state = _states[tile];
+        --state.Outstanding;
+        if (state.Done) {
+            return false;
+        }
+        state.Done = true;
+        --_remaining;
+        _durations.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - state.IssuedAt).count());
+        _cv.notify_all();
+        return true;
+    }
+
+    void TileScheduler::Release(std::size_t tile) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        TileState& state = _states[tile];
+        --state.Outstanding;
+        if (!state.Done && state.Outstanding == 0) {
+            _pending.push_front(tile);
+            _cv.notify_one();
+        }
+    }
+
+    bool TileScheduler::IsFinished() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _remaining == 0;
+    }
+
+    std::size_t TileScheduler::GetTileCount() const {
+        return _tiles.size();
+    }
+
+    Tile const& TileScheduler::GetTile(std::size_t tile) const {
+        return _tiles[tile];
+    }
+
+    std::size_t TileScheduler::GetReissued() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _reissued;
+    }
+
+    bool TileScheduler::_findStraggler(std::size_t& tile) {
+        if (_durations.empty()) {
+            return false;
+        }
+        auto const now = std::chrono::steady_clock::now();
+        float const threshold = StragglerFactor * _medianDuration();
+        bool found = false;
+        for (std::size_t i = 0; i < _states.size(); ++i) {
+            TileState const& state = _states[i];
+            if (state.Done || state.Outstanding == 0 || state.Outstanding >= MaxCopies) {
+                continue;
+            }
+            float const age = std::chrono::duration<float, std::milli>(now - state.IssuedAt).count();
+            if (age > threshold && (!found || state.IssuedAt < _states[tile].IssuedAt)) {
+                tile = i;
+                found = true;
+            }
+        }
+        if (found) {
+            ++_reissued;
+        }
+        return found;
+    }
+
+    float TileScheduler::_medianDuration() {
+        auto middle = _durations.begin() + _durations.size() / 2;
+        std::nth_element(_durations.begin(), middle, _durations.end());
+        return *middle;
+    }
+}  // namespace rt
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "../Engine/Tools.h"
+#include "../Vector/Vector2.h"
+
+namespace rt {
+    // Hands out tiles to workers on demand. Once nothing is left to hand out, idle
+    // workers get a second copy of tiles that have been outstanding for much longer
+    // than the median tile; whichever copy completes first wins.
+    class TileScheduler {
+    public:
+        TileScheduler(Vector2<unsigned int> const& res, unsigned int tileSize);
+
+        bool            Next(std::size_t& tile);
+        bool            Complete(std::size_t tile);
+        void            Release(std::size_t tile);
+
+        bool            IsFinished() const;
+        std::size_t     GetTileCount() const;
+        Tile const&     GetTile(std::size_t tile) const;
+        std::size_t     GetReissued() const;
+
+        static constexpr float          StragglerFactor = 3.f;
+        static constexpr unsigned int   MaxCopies = 2;
+
+    private:
+        struct TileState {
+            bool                                    Done = false;
+            unsigned int                            Outstanding = 0;
+            std::chrono::steady_clock::time_point   IssuedAt;
+        };
+
+        mutable std::mutex          _mutex;
+        std::condition_variable     _cv;
+        std::vector<Tile>           _tiles;
+        std::vector<TileState>      _states;
+        std::deque<std::size_t>     _pending;
+        std::vector<float>          _durations;
+        std::size_t                 _remaining;
+        std::size_t                 _reissued;
+
+        bool    _findStraggler(std::size_t& tile);
+        float   _medianDuration();
+    };
+}  // namespace rt
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "../Engine/Engine.h"
+#include "../Loader/AssimpLoader.h"
+#include "../Render/ThreadPool.h"
+#include "../Render/TileRenderer.h"
+#include "Protocol.h"
+#include "Worker.h"
+
+namespace rt {
+    Worker::Worker(unsigned int threadCount) : _threadCount(threadCount) {
+    }
+
+    bool Worker::Run(std::string const& host, std::uint16_t port) {
+        if (!_connect(host, port)) {
+            std::cerr << "Cannot connect to " << host << ":" << port << std::endl;
+            return false;
+        }
+        Message hello(static_cast<std::uint8_t>(MessageType::Hello));
+        hello.Write(static_cast<std::uint32_t>(std::max(_threadCount, 1u)));
+        Message scene;
+        RenderJob job;
+        if (!hello.Send(_link) || !scene.Receive(_link) || scene.GetType() != static_cast<std::uint8_t>(MessageType::Scene)
+            || !ReadJob(scene, job)) {
+            std::cerr << "Handshake with coordinator failed" << std::endl;
+            return false;
+        }
+        if (HashFile(job.ScenePath) != job.SceneHash) {
+            return _fail("scene " + job.ScenePath + " is missing or differs from the coordinator's copy");
+        }
+
+        AssimpLoader loader;
+        loader.SetLodOptions(job.Lod);
+        if (!loader.LoadFile(job.ScenePath)) {
+            return _fail("cannot load scene " + job.ScenePath);
+        }
+        AccelOptions accel = job.Accel;
+        accel.BuildThreads = _threadCount;
+        Engine engine{loader.TakeScene(), accel};
+        engine.SetShading(job.Shading);
+        Camera camera = *engine.GetCamera();
+        camera.SetPose(job.Pose);
+        camera.SetFOV(job.FOV);
+        camera.SetRes(job.Res);
+        engine.SetLevelOfDetail(job.LodPixels * camera.GetPixelAngle());
+        ThreadPool pool(_threadCount);
+        TileRenderer renderer(engine, pool);
+        if (!Message(static_cast<std::uint8_t>(MessageType::Ready)).Send(_link)) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> pixels;
+        Message request;
+        while (request.Receive(_link)) {
+            if (request.GetType() == static_cast<std::uint8_t>(MessageType::Done)) {
+                return true;
+            }
+            std::uint32_t id = 0;
+            Tile tile;
+            if (request.GetType() != static_cast<std::uint8_t>(MessageType::Tile) || !request.Read(id) || !request.Read(tile)) {
+                return _fail("unexpected message");
+            }
+            auto const start = std::chrono::steady_clock::now();
+            pixels.resize(static_cast<std::size_t>(tile.Width) * tile.Height * 4);
+            renderer.Render(camera, tile, job.Spp, pixels.data(), static_cast<std::size_t>(tile.Width) * 4);
+            float const renderTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            Message result(static_cast<std::uint8_t>(MessageType::TileResult));
+            result.Write(id).Write(renderTime).WriteBytes(pixels.data(), pixels.size());
+            if (!result.Send(_link)) {
+                return false;
+            }
+        }
+        std::cerr << "Connection to coordinator lost" << std::endl;
+        return false;
+    }
+
+    bool Worker::_connect(std::string const& host, std::uint16_t port) {
+        // Workers may be started before the coordinator listens
+        for (int attempt = 0; attempt < ConnectAttempts; ++attempt) {
+            if (_link.Connect(host, port)) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return false;
+    }
+
+    bool Worker::_fail(std::string const& error) {
+        std::cerr << "Worker error: " << error << std::endl;
+        Message message(static_cast<std::uint8_t>(MessageType::Error));
+        message.WriteString(error);
+        message.Send(_link);
+        return false;
+    }
+}  // namespace rt
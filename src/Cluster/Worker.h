@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "../Net/Socket.h"
+
+namespace rt {
+    // Connects to a coordinator, loads the scene it names and renders tiles until told to stop.
+    class Worker {
+    public:
+        explicit    Worker(unsigned int threadCount);
+
+        bool    Run(std::string const& host, std::uint16_t port);
+
+        static constexpr int ConnectAttempts = 50;
+
+    private:
+        unsigned int    _threadCount;
+        Socket          _link;
+
+        bool    _connect(std::string const& host, std::uint16_t port);
+        bool    _fail(std::string const& error);
+    };
+}  // namespace rt
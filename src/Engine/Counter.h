@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace rt {
+    // Event count shared by the threads tracing through one engine. Copies start
+    // from the current value, so classes holding one keep their copy constructor.
+    class Counter {
+    public:
+        Counter() = default;
+        Counter(Counter const& other) : _value(other.Get()) {}
+        Counter&    operator=(Counter const& other) {
+            _value.store(other.Get(), std::memory_order_relaxed);
+            return *this;
+        }
+
+        void            Add(std::uint64_t count) const {
+            _value.fetch_add(count, std::memory_order_relaxed);
+        }
+        std::uint64_t   Get() const {
+            return _value.load(std::memory_order_relaxed);
+        }
+        void            Reset() const {
+            _value.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        mutable std::atomic<std::uint64_t>  _value{0};
+    };
+}  // namespace rt
@@ -1,51 +1,790 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <vector>
 #include <thread>
 #include "Engine.h"
-#include "../Light/PointLight.h"
+#include "Memory.h"
 
 namespace rt {
-    Engine::Engine(AssimpLoader const &loader) : _loader(loader), _camera(loader.GetCameraFromScene()) {
-        _meshes = loader.GetMeshesFromScene();
-        _lights = loader.GetLightsFromScene();
+    namespace {
+        std::uint32_t hashBits(std::uint32_t value) {
+            value ^= value >> 16;
+            value *= 0x7feb352du;
+            value ^= value >> 15;
+            value *= 0x846ca68bu;
+            value ^= value >> 16;
+            return value;
+        }
+
+        std::uint32_t floatBits(float value) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        // Seeds the occlusion samples from the primary ray, so images are the same however they are tiled
+        std::uint32_t raySeed(Ray const& ray) {
+            return hashBits(floatBits(ray.Direction.X) ^ hashBits(floatBits(ray.Direction.Y)
+                ^ hashBits(floatBits(ray.Direction.Z) ^ hashBits(floatBits(ray.Origin.X)))));
+        }
+
+        // Hemisphere around the normal, facing the incoming ray, with an orthonormal basis (Duff et al. 2017)
+        struct Hemisphere {
+            Hemisphere(Vector3<float> normal, Vector3<float> const& incoming) {
+                if (normal.Dot(incoming) > 0.f) {
+                    normal = normal * -1.f;
+                }
+                float const sign = std::copysign(1.f, normal.Z);
+                float const a = -1.f / (sign + normal.Z);
+                float const b = normal.X * normal.Y * a;
+                Normal = normal;
+                Tangent = Vector3<float>(1.f + sign * normal.X * normal.X * a, sign * b, -sign * normal.X);
+                Bitangent = Vector3<float>(b, sign + normal.Y * normal.Y * a, -normal.Y);
+            }
+
+            // Cosine-distributed direction for sample index of the given seed
+            Vector3<float>  Sample(std::uint32_t seed, unsigned int index) const {
+                float const u1 = hashBits(seed + 2 * index) * (1.f / 4294967296.f);
+                float const u2 = hashBits(seed + 2 * index + 1) * (1.f / 4294967296.f);
+                float const radius = std::sqrt(u1);
+                float const phi = 2.f * Constant::PI * u2;
+                return Tangent * (radius * std::cos(phi)) + Bitangent * (radius * std::sin(phi))
+                     + Normal * std::sqrt(std::max(0.f, 1.f - u1));
+            }
+
+            Vector3<float>  Normal;
+            Vector3<float>  Tangent;
+            Vector3<float>  Bitangent;
+        };
+
+        // Occlusion rays of one batch of primary rays, reused by the thread between batches
+        struct AOBatch {
+            std::vector<std::uint32_t>  Pixels;
+            std::vector<Ray>            Rays;
+            std::vector<std::uint32_t>  Owners;
+            std::vector<std::uint32_t>  Visible;
+        };
+
+        // Spatial splits clip triangles, so hierarchies that also hold proxy boxes take binned SAH instead
+        void buildHierarchy(BVH& bvh, std::vector<TriangleVertices> const& vertices, std::vector<AABB> const& proxies,
+                            AccelOptions const& accel, ThreadPool& pool) {
+            if (accel.Builder == BVHBuilder::SBVH && proxies.empty()) {
+                bvh.BuildSpatial(vertices, accel.SpatialOverhead, pool);
+                return;
+            }
+            std::vector<AABB> bounds(vertices.size());
+            for (std::size_t i = 0; i < vertices.size(); ++i) {
+                for (Vector3<float> const& vertex : vertices[i]) {
+                    bounds[i].Grow(vertex);
+                }
+            }
+            bounds.insert(bounds.end(), proxies.begin(), proxies.end());
+            bvh.Build(bounds, accel.Builder == BVHBuilder::SBVH ? BVHBuilder::BinnedSAH : accel.Builder, pool);
+        }
+
+        // Last occluding slot per light of the engine the thread shaded with most recently, by identity
+        struct OccluderCache {
+            std::uint64_t               Owner = 0;
+            std::vector<std::uint32_t>  Slots;
+        };
+
+        bool sharedOrigin(RayBuffer const& rays) {
+            for (std::size_t i = 1; i < rays.Size(); ++i) {
+                if (rays.OriginX[i] != rays.OriginX[0] || rays.OriginY[i] != rays.OriginY[0] || rays.OriginZ[i] != rays.OriginZ[0]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    std::uint64_t Engine::Identity::Next() {
+        static std::atomic<std::uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Engine::Engine(Scene&& scene, AccelOptions const& accel) : _camera(scene.GetCamera()), _lights(scene.GetLights()),
+        _accel(accel) {
+        if (_accel.Width != 4 && _accel.Width != 8) {
+            _accel.Width = 2;
+        }
+        if (_accel.BuildThreads == 0) {
+            _accel.BuildThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        // The scene's triangles already carry their object's colour, so a single hierarchy covers the scene.
+        // Objects with levels of detail enter it as one proxy box each, their levels get hierarchies of their own.
+        std::vector<Triangle> const& triangles = scene.GetTriangles();
+        std::vector<std::uint32_t> inputs;
+        std::vector<TriangleVertices> vertices;
+        std::vector<AABB> proxies;
+        for (SceneObject const& object : scene.GetObjects()) {
+            if (object.LodCount > 0) {
+                LodObject lod;
+                lod.FirstLevel = static_cast<std::uint32_t>(_lodLevels.size());
+                lod.LevelCount = object.LodCount + 1;
+                for (std::uint32_t i = object.FirstTriangle; i < object.FirstTriangle + object.TriangleCount; ++i) {
+                    lod.Bounds.Grow(triangles[i].GetV1().GetPos());
+                    lod.Bounds.Grow(triangles[i].GetV2().GetPos());
+                    lod.Bounds.Grow(triangles[i].GetV3().GetPos());
+                }
+                proxies.push_back(lod.Bounds);
+                _lodObjects.push_back(lod);
+                _lodLevels.resize(_lodLevels.size() + lod.LevelCount);
+                continue;
+            }
+            for (std::uint32_t i = object.FirstTriangle; i < object.FirstTriangle + object.TriangleCount; ++i) {
+                inputs.push_back(i);
+                vertices.push_back({triangles[i].GetV1().GetPos(), triangles[i].GetV2().GetPos(), triangles[i].GetV3().GetPos()});
+            }
+        }
+        ThreadPool pool(_accel.BuildThreads);
+        buildHierarchy(_bvh, vertices, proxies, accel, pool);
+        // Store triangles in leaf order so each leaf reads a contiguous run, spatial
+        // splits copy a triangle into every leaf that references it
+        std::vector<std::uint32_t> const& indices = _bvh.GetIndices();
+        _triangles.reserve(indices.size());
+        Vertex const origin{Vector3<float>()};
+        Triangle const placeholder(origin, origin, origin);
+        for (std::uint32_t index : indices) {
+            bool const proxy = index >= inputs.size();
+            _triangles.push_back(proxy ? placeholder : triangles[inputs[index]]);
+            if (!_lodObjects.empty()) {
+                _proxies.push_back(proxy ? static_cast<std::uint32_t>(index - inputs.size()) : RayHit::NoHit);
+                _primitives.push_back(proxy ? RayHit::NoHit : inputs[index]);
+            }
+        }
+        _collapse(_bvh, _bvh4, _bvh8);
+
+        // Level 0 is the object's own mesh, the scene's simplified levels follow
+        std::vector<SceneLod> const& lods = scene.GetLods();
+        std::uint32_t lodObject = 0;
+        for (SceneObject const& object : scene.GetObjects()) {
+            if (object.LodCount == 0) {
+                continue;
+            }
+            for (std::uint32_t i = 0; i <= object.LodCount; ++i) {
+                LodLevel& level = _lodLevels[_lodObjects[lodObject].FirstLevel + i];
+                std::vector<Triangle> const& source = i == 0 ? triangles : scene.GetLodTriangles();
+                std::uint32_t const first = i == 0 ? object.FirstTriangle : lods[object.FirstLod + i - 1].FirstTriangle;
+                std::uint32_t const count = i == 0 ? object.TriangleCount : lods[object.FirstLod + i - 1].TriangleCount;
+                level.FirstSlot = static_cast<std::uint32_t>(_triangles.size());
+                level.Object = lodObject;
+                level.Error = i == 0 ? 0.f : lods[object.FirstLod + i - 1].Error;
+                vertices.clear();
+                for (std::uint32_t t = first; t < first + count; ++t) {
+                    vertices.push_back({source[t].GetV1().GetPos(), source[t].GetV2().GetPos(), source[t].GetV3().GetPos()});
+                }
+                buildHierarchy(level.Bvh, vertices, std::vector<AABB>(), accel, pool);
+                for (std::uint32_t index : level.Bvh.GetIndices()) {
+                    _triangles.push_back(source[first + index]);
+                    _primitives.push_back(i == 0 ? first + index : RayHit::NoHit);
+                }
+                _collapse(level.Bvh, level.Bvh4, level.Bvh8);
+            }
+            ++lodObject;
+        }
+        std::vector<TriangleVertices>().swap(vertices);
+        scene.Clear();
+
+        std::size_t smooth = 0;
+        std::size_t placeholders = 0;
+        for (std::size_t slot = 0; slot < _triangles.size(); ++slot) {
+            if (slot < _proxies.size() && _proxies[slot] != RayHit::NoHit) {
+                ++placeholders;
+            } else {
+                smooth += _triangles[slot].HasVertexNormals();
+            }
+        }
+        _features.Normals = smooth == 0 ? NormalMode::Flat
+                          : (smooth + placeholders == _triangles.size() ? NormalMode::Smooth : NormalMode::PerTriangle);
+        _features.SingleLight = _lights.size() == 1;
+        _buildLightBVH(pool);
+        _selectKernels();
+        ReleaseFreeMemory();
+    }
+
+    void Engine::_collapse(BVH& bvh, WideBVH<4>& bvh4, WideBVH<8>& bvh8) const {
+        if (_accel.Width == 4) {
+            bvh4.Build(bvh);
+        } else if (_accel.Width == 8) {
+            bvh8.Build(bvh);
+        }
+        if (_accel.Width != 2) {
+            bvh.ReleaseNodes();
+        }
     }
 
     Color Engine::Raytrace(const rt::Vector2<unsigned int> &pixel) {
+        return Raytrace(_camera.GenerateRay(pixel));
+    }
+
+    Color Engine::Raytrace(Ray const& ray) const {
+        return (this->*_kernel)(ray);
+    }
+
+    void Engine::Raytrace(RayBuffer const& rays, std::vector<Color>& colors) const {
+        (this->*_batchKernel)(rays, nullptr, colors);
+    }
+
+    void Engine::Raytrace(RayBuffer const& rays, Span<VisibilitySample const> visibility, std::vector<Color>& colors) const {
+        (this->*_batchKernel)(rays, visibility.Size() >= rays.Size() ? visibility.Data() : nullptr, colors);
+    }
+
+    void Engine::GetCameraSlots(Vector3<float> const& eye, std::vector<std::uint32_t>& slots) const {
+        slots.clear();
+        // Slots are visited in increasing order, so the first holding a triangle is the lowest
+        std::vector<std::uint8_t> listed;
+        auto addFirst = [&](std::uint32_t slot, std::uint32_t index) {
+            if (index >= listed.size()) {
+                listed.resize(index + 1, 0);
+            }
+            if (!listed[index]) {
+                listed[index] = 1;
+                slots.push_back(slot);
+            }
+        };
+        std::vector<std::uint32_t> const& indices = _bvh.GetIndices();
+        std::size_t const sceneSlots = _lodLevels.empty() ? _triangles.size() : _lodLevels[0].FirstSlot;
+        listed.reserve(sceneSlots);
+        for (std::uint32_t slot = 0; slot < sceneSlots; ++slot) {
+            if (slot >= _proxies.size() || _proxies[slot] == RayHit::NoHit) {
+                addFirst(slot, indices[slot]);
+            }
+        }
+        LodView const view{eye, _lodScale};
+        for (std::uint32_t object = 0; object < _lodObjects.size(); ++object) {
+            LodLevel const& level = _lodLevels[_selectLevel(object, view)];
+            std::vector<std::uint32_t> const& levelIndices = level.Bvh.GetIndices();
+            listed.assign(level.Bvh.GetStats().Primitives, 0);
+            for (std::uint32_t local = 0; local < levelIndices.size(); ++local) {
+                addFirst(level.FirstSlot + local, levelIndices[local]);
+            }
+        }
+    }
+
+    void Engine::SetShading(ShadingOptions const& shading) {
+        SetShadows(shading.Shadows);
+        SetOccluderCache(shading.OccluderCache);
+        SetTileCulling(shading.TileCulling);
+        SetLightRadius(shading.LightRadius);
+        SetAmbientOcclusion(shading.AO);
+    }
+
+    void Engine::SetShadows(bool shadows) {
+        _features.Shadows = shadows;
+        _selectKernels();
+    }
+
+    void Engine::SetLightRadius(float radius) {
+        for (PointLight& light : _lights) {
+            light.SetRadius(radius);
+        }
+        ThreadPool pool(_accel.BuildThreads);
+        _buildLightBVH(pool);
+    }
+
+    void Engine::SetAmbientOcclusion(AOOptions const& ao) {
+        _ao = ao;
+        _selectKernels();
+    }
+
+    void Engine::ReportKernel(std::ostream& out) const {
+        if (_ao.Samples > 0) {
+            out << "Kernel: ambient occlusion, " << _ao.Samples << " rays per hit up to " << _ao.Distance << std::endl;
+            return;
+        }
+        static char const* const normals[] = {"flat", "smooth", "per-triangle"};
+        out << "Kernel: " << normals[static_cast<int>(_features.Normals)] << " normals, "
+            << (_features.Shadows ? "shadows" : "no shadows") << ", "
+            << (_features.SingleLight ? "single light" : "light loop") << std::endl;
+    }
+
+    void Engine::ReportAO(float milliseconds, std::ostream& out) const {
+        double const rays = static_cast<double>(_aoRays.Get());
+        out << std::fixed << std::setprecision(2) << "AO rays: " << _aoRays.Get() << ", AO rays/s: "
+            << (milliseconds > 0.f ? rays / milliseconds * 1000.0 / 1e6 : 0.0) << " M" << std::endl;
+    }
+
+    void Engine::ReportLods(std::ostream& out) const {
+        if (_lodObjects.empty()) {
+            return;
+        }
+        std::size_t triangles = 0;
+        float error = 0.f;
+        for (LodLevel const& level : _lodLevels) {
+            triangles += level.Bvh.GetStats().References;
+            error = std::max(error, level.Error);
+        }
+        out << std::defaultfloat << std::setprecision(3) << "Levels of detail: " << _lodObjects.size() << " objects, "
+            << _lodLevels.size() << " levels, " << triangles << " triangles, largest error " << error
+            << ", error allowed per unit of distance " << _lodScale << std::endl;
+    }
+
+    void Engine::ReportLights(std::ostream& out) const {
+        std::size_t const evaluations = _lightEvaluations.Get();
+        out << std::fixed << std::setprecision(2) << "Lights: " << _lights.size() << ", "
+            << _lights.size() - _unboundedLights << " bounded (" << _lightBVH.GetStats().Nodes << " nodes), "
+            << evaluations << " evaluations, " << _culledLights.Get() << " culled ("
+            << (evaluations > 0 ? 100.0 * _culledLights.Get() / evaluations : 0.0) << "%)" << std::endl;
+        std::size_t const shadowRays = _shadowRays.Get();
+        out << "Shadow rays: " << shadowRays << ", " << _occluderCacheHits.Get() << " answered by the occluder cache ("
+            << (shadowRays > 0 ? 100.0 * _occluderCacheHits.Get() / shadowRays : 0.0) << "%"
+            << (_cacheOccluders ? "" : ", disabled") << ")" << std::endl;
+    }
+
+    void Engine::ReportCulling(std::ostream& out) const {
+        std::size_t const tiles = _culledTiles.Get();
+        out << std::fixed << std::setprecision(2) << "Tile culling: " << tiles << " tiles, "
+            << (tiles > 0 ? static_cast<double>(_tileRoots.Get()) / tiles : 0.0) << " subtrees per tile of at most "
+            << BVH::MaxRoots << ", " << _emptyTiles.Get() << " with nothing in view" << (_cullTiles ? "" : ", disabled") << std::endl;
+    }
+
+    void Engine::ReportVisibility(std::ostream& out) const {
+        std::size_t const rays = _rasterRays.Get();
+        out << std::fixed << std::setprecision(2) << "Visibility buffer: " << rays << " rays, " << _rasterSeeded.Get()
+            << " started from a rasterized hit, " << _rasterSettled.Get() << " settled without traversal ("
+            << (rays > 0 ? 100.0 * _rasterSettled.Get() / rays : 0.0) << "%)" << std::endl;
+    }
+
+    void Engine::AddCounters(Engine const& other) const {
+        std::array<Counter const*, 11> const mine = _counters();
+        std::array<Counter const*, 11> const theirs = other._counters();
+        for (std::size_t i = 0; i < mine.size(); ++i) {
+            mine[i]->Add(theirs[i]->Get());
+        }
+    }
+
+    void Engine::ResetCounters() const {
+        for (Counter const* counter : _counters()) {
+            counter->Reset();
+        }
+    }
+
+    std::array<Counter const*, 11> Engine::_counters() const {
+        return {&_aoRays, &_lightEvaluations, &_culledLights, &_shadowRays, &_occluderCacheHits, &_culledTiles,
+                &_tileRoots, &_emptyTiles, &_rasterRays, &_rasterSeeded, &_rasterSettled};
+    }
+
+    // Lights without distance falloff reach everything and stay in a flat list, the others
+    // are bounded by their radius so a hit only visits the spheres it lies in
+    void Engine::_buildLightBVH(ThreadPool& pool) {
+        std::stable_partition(_lights.begin(), _lights.end(), [](PointLight const& light) {
+            return !light.IsBounded();
+        });
+        _unboundedLights = static_cast<std::size_t>(std::count_if(_lights.begin(), _lights.end(), [](PointLight const& light) {
+            return !light.IsBounded();
+        }));
+        std::vector<AABB> bounds;
+        for (std::size_t i = _unboundedLights; i < _lights.size(); ++i) {
+            Vector3<float> const extent(_lights[i].GetRadius(), _lights[i].GetRadius(), _lights[i].GetRadius());
+            bounds.emplace_back();
+            bounds.back().Grow(_lights[i].GetPos() - extent);
+            bounds.back().Grow(_lights[i].GetPos() + extent);
+        }
+        _lightBVH = BVH();
+        if (bounds.empty()) {
+            return;
+        }
+        _lightBVH.Build(bounds, BVHBuilder::BinnedSAH, pool);
+        std::vector<PointLight> ordered(_lights.begin(), _lights.begin() + _unboundedLights);
+        for (std::uint32_t index : _lightBVH.GetIndices()) {
+            ordered.push_back(_lights[_unboundedLights + index]);
+        }
+        _lights = std::move(ordered);
+    }
+
+    template <bool SingleLight, class Shade>
+    void Engine::_forEachLight(Vector3<float> const& point, LightTally& tally, Shade&& shade) const {
+        tally.Evaluations += _lights.size();
+        auto reach = [&](PointLight const& light) {
+            Vector3<float> const toLight = light.GetPos() - point;
+            float const distance = toLight.Norm();
+            if (distance < light.GetRadius()) {
+                ++tally.Shaded;
+                shade(light, toLight, distance);
+            }
+        };
+        if constexpr (SingleLight) {
+            reach(_lights[0]);
+        } else {
+            for (std::size_t i = 0; i < _unboundedLights; ++i) {
+                reach(_lights[i]);
+            }
+            _lightBVH.Query(point, [&](std::uint32_t slot) {
+                reach(_lights[_unboundedLights + slot]);
+            });
+        }
+    }
+
+    void Engine::_addTally(LightTally const& tally) const {
+        if (tally.Evaluations > 0) {
+            _lightEvaluations.Add(tally.Evaluations);
+            _culledLights.Add(tally.Evaluations - tally.Shaded);
+        }
+        if (tally.ShadowRays > 0) {
+            _shadowRays.Add(tally.ShadowRays);
+            _occluderCacheHits.Add(tally.CacheHits);
+        }
+    }
+
+    template <class... Cost>
+    bool Engine::_closestHit(Ray const& ray, LodView const& view, Roots roots, Hit& hit, Cost&... cost) const {
+        bool found = hit.Slot != RayHit::NoHit;
+        _traverse(ray, found ? hit.Dist : std::numeric_limits<float>::max(), view, roots, [&](std::uint32_t slot, float& tMax) {
+            float t;
+            float u;
+            float v;
+            // Ties on shared edges go to the lowest slot, so every hierarchy picks the same triangle
+            if (_triangles[slot].Hit(ray, t, u, v) && (t < tMax || (t == tMax && slot < hit.Slot))) {
+                tMax = t;
+                hit = Hit{slot, t, u, v};
+                found = true;
+            }
+            return false;
+        }, cost...);
+        return found;
+    }
+
+    template <class... Cost>
+    bool Engine::_occluded(Ray const& ray, float maxDistance, LodView const& view, Cost&... cost) const {
+        return _occluder(ray, maxDistance, view, cost...) != RayHit::NoHit;
+    }
+
+    template <class... Cost>
+    std::uint32_t Engine::_occluder(Ray const& ray, float maxDistance, LodView const& view, Cost&... cost) const {
+        std::uint32_t occluder = RayHit::NoHit;
+        _traverse(ray, maxDistance, view, nullptr, [&](std::uint32_t slot, float& tMax) {
+            float t;
+            float u;
+            float v;
+            if (_triangles[slot].Hit(ray, t, u, v) && t <= tMax) {
+                occluder = slot;
+                return true;
+            }
+            return false;
+        }, cost...);
+        return occluder;
+    }
+
+    // Any triangle within the distance blocks the light, so a stale cached slot can only miss, never give a
+    // wrong answer. That holds as long as the slot belongs to a level of detail the view traces.
+    template <class... Cost>
+    bool Engine::_shadowed(Ray const& ray, float distance, LodView const& view, std::size_t light,
+                           std::uint32_t* cache, LightTally& tally, Cost&... cost) const {
+        ++tally.ShadowRays;
+        if (cache != nullptr && cache[light] != RayHit::NoHit && _inView(cache[light], view)) {
+            float t;
+            float u;
+            float v;
+            ((++cost.Triangles), ...);
+            if (_triangles[cache[light]].Hit(ray, t, u, v) && t <= distance) {
+                ++tally.CacheHits;
+                return true;
+            }
+        }
+        std::uint32_t const occluder = _occluder(ray, distance, view, cost...);
+        if (occluder == RayHit::NoHit) {
+            return false;
+        }
+        if (cache != nullptr) {
+            cache[light] = occluder;
+        }
+        return true;
+    }
+
+    std::uint32_t Engine::_selectLevel(std::uint32_t object, LodView const& view) const {
+        LodObject const& lod = _lodObjects[object];
+        float const footprint = view.Scale * lod.Bounds.Distance(view.Apex);
+        std::uint32_t level = lod.FirstLevel;
+        while (level + 1 < lod.FirstLevel + lod.LevelCount && _lodLevels[level + 1].Error <= footprint) {
+            ++level;
+        }
+        return level;
+    }
+
+    bool Engine::_inView(std::uint32_t slot, LodView const& view) const {
+        if (_lodLevels.empty() || slot < _lodLevels[0].FirstSlot) {
+            return true;
+        }
+        auto const level = std::upper_bound(_lodLevels.begin(), _lodLevels.end(), slot, [](std::uint32_t value, LodLevel const& entry) {
+            return value < entry.FirstSlot;
+        }) - 1;
+        return _selectLevel(level->Object, view) == static_cast<std::uint32_t>(level - _lodLevels.begin());
+    }
+
+    bool Engine::_seedHit(Ray const& ray, VisibilitySample const& sample, Hit& hit, VisibilityTally& tally) const {
+        ++tally.Rays;
+        if (sample.Slot != RayHit::NoHit) {
+            float t;
+            float u;
+            float v;
+            // A settled triangle the ray misses means the rasterizer was wrong, so the ray is traced
+            if (!_triangles[sample.Slot].Hit(ray, t, u, v)) {
+                return false;
+            }
+            hit = Hit{sample.Slot, t, u, v};
+            ++tally.Seeded;
+        }
+        tally.Settled += sample.Settled;
+        return sample.Settled;
+    }
+
+    void Engine::_addVisibility(VisibilityTally const& tally) const {
+        _rasterRays.Add(tally.Rays);
+        _rasterSeeded.Add(tally.Seeded);
+        _rasterSettled.Add(tally.Settled);
+    }
+
+    // Camera rays of a tile share the camera position, while rays from elsewhere may not
+    Engine::Roots Engine::_cullTile(RayBuffer const& rays) const {
+        if (!_cullTiles || rays.Size() == 0 || !sharedOrigin(rays)) {
+            return nullptr;
+        }
+        Frustum frustum;
+        Vector3<float> const apex(rays.OriginX[0], rays.OriginY[0], rays.OriginZ[0]);
+        if (!frustum.Enclose(apex, rays.Size(), [&](std::size_t i) {
+            return Vector3<float>(rays.DirectionX[i], rays.DirectionY[i], rays.DirectionZ[i]);
+        })) {
+            return nullptr;
+        }
+        thread_local std::vector<TraversalRoot> roots;
+        if (_accel.Width == 8) {
+            _bvh8.Cull(frustum, roots);
+        } else if (_accel.Width == 4) {
+            _bvh4.Cull(frustum, roots);
+        } else {
+            _bvh.Cull(frustum, roots);
+        }
+        _culledTiles.Add(1);
+        _tileRoots.Add(roots.size());
+        if (roots.empty()) {
+            _emptyTiles.Add(1);
+        }
+        return &roots;
+    }
+
+    std::uint32_t* Engine::_occluderCache() const {
+        if (!_cacheOccluders) {
+            return nullptr;
+        }
+        thread_local OccluderCache cache;
+        if (cache.Owner != _identity.Value || cache.Slots.size() != _lights.size()) {
+            cache.Owner = _identity.Value;
+            cache.Slots.assign(_lights.size(), RayHit::NoHit);
+        }
+        return cache.Slots.data();
+    }
+
+    void Engine::MeasureCost(RayBuffer const& rays, Span<TraversalCost> primary, Span<TraversalCost> secondary,
+                             Span<unsigned int> secondaryRays) const {
+        Roots const roots = _cullTile(rays);
+        std::size_t const count = std::min({rays.Size(), primary.Size(), secondary.Size(), secondaryRays.Size()});
+        for (std::size_t i = 0; i < count; ++i) {
+            secondaryRays[i] = _measureCost(rays.GetRay(i), roots, primary[i], secondary[i]);
+        }
+    }
+
+    unsigned int Engine::_measureCost(Ray const& ray, Roots roots, TraversalCost& primary, TraversalCost& secondary) const {
+        LodView const view = _lodView(ray);
+        Hit hit;
+        if (!_closestHit(ray, view, roots, hit, primary)) {
+            return 0;
+        }
+        Vector3<float> const point = ray.Origin + ray.Direction * hit.Dist;
+        if (_ao.Samples > 0) {
+            Hemisphere const hemisphere(_triangles[hit.Slot].GetNormal(), ray.Direction);
+            std::uint32_t const seed = raySeed(ray);
+            for (unsigned int sample = 0; sample < _ao.Samples; ++sample) {
+                _occluded(Ray(point, hemisphere.Sample(seed, sample)), _ao.Distance, view, secondary);
+            }
+            return _ao.Samples;
+        }
+        if (!_features.Shadows) {
+            return 0;
+        }
+        LightTally tally;
+        std::uint32_t* const cache = _occluderCache();
+        _forEachLight<false>(point, tally, [&](PointLight const& light, Vector3<float> lightDir, float distance) {
+            lightDir.Normalize();
+            _shadowed(Ray(point, lightDir), distance, view, &light - _lights.data(), cache, tally, secondary);
+        });
+        return static_cast<unsigned int>(tally.Shaded);
+    }
+
+    void Engine::IntersectBatch(Span<Ray const> rays, Span<RayHit> hits) const {
+        std::size_t const count = std::min(rays.Size(), hits.Size());
+        std::vector<std::uint32_t> const& primitives = _primitives.empty() ? _bvh.GetIndices() : _primitives;
+        for (std::size_t i = 0; i < count; ++i) {
+            Hit hit;
+            hits[i] = RayHit();
+            if (_closestHit(rays[i], LodView(), nullptr, hit)) {
+                hits[i].Dist = hit.Dist;
+                hits[i].Primitive = primitives[hit.Slot];
+                hits[i].U = hit.U;
+                hits[i].V = hit.V;
+                hits[i].Normal = _triangles[hit.Slot].GetNormal();
+            }
+        }
+    }
+
+    void Engine::OccludedBatch(Span<Ray const> rays, Span<float const> maxDistances, Span<std::uint8_t> occluded) const {
+        std::size_t const count = std::min({rays.Size(), maxDistances.Size(), occluded.Size()});
+        for (std::size_t i = 0; i < count; ++i) {
+            occluded[i] = _occluded(rays[i], maxDistances[i], LodView());
+        }
+    }
+
+    // Only the closest hit gets a normal, and every feature test below is resolved at compile time
+    template <NormalMode Normals, bool Shadows, bool SingleLight>
+    Color Engine::_shadeHit(Ray const& ray, Roots roots, Hit hit, bool settled, LightTally& tally) const {
         Color color = Color();
-        Ray ray = _camera.GenerateRay(pixel);
-        Intersection inter = _intersect(ray);
-        if (inter.Intersect) {
-            for (size_t i = 0; i < _lights.size(); ++i) {
-                Vector3<float> lightDir = _lights[i]->GetPos() - inter.Point;
-                lightDir.Normalize();
-                Intersection interLight = _intersect(Ray(inter.Point, lightDir));
-                if (!interLight.Intersect ||
-                    interLight.Dist > (_lights[i]->GetPos() - inter.Point).Norm()) {
-                    float angle = lightDir.Angle(inter.Normal);
-                    if (angle > 90.f) {
-                        angle = 180.f - angle;
-                    }
-                    color += (Color(inter.DiffuseColor) * ((-1.f / 90.f) * angle + 1.f));
+        LodView const view = _lodView(ray);
+        if (settled ? hit.Slot == RayHit::NoHit : !_closestHit(ray, view, roots, hit)) {
+            return color;
+        }
+        Triangle const& triangle = _triangles[hit.Slot];
+        Vector3<float> const point = ray.Origin + ray.Direction * hit.Dist;
+        Vector3<float> normal;
+        if constexpr (Normals == NormalMode::PerTriangle) {
+            normal = triangle.HasVertexNormals() ? triangle.GetNormalAt<true>(hit.U, hit.V) : triangle.GetNormalAt<false>(hit.U, hit.V);
+        } else {
+            normal = triangle.GetNormalAt<Normals == NormalMode::Smooth>(hit.U, hit.V);
+        }
+
+        std::uint32_t* cache = nullptr;
+        if constexpr (Shadows) {
+            cache = _occluderCache();
+        }
+        _forEachLight<SingleLight>(point, tally, [&](PointLight const& pointLight, Vector3<float> lightDir, float distance) {
+            lightDir.Normalize();
+            if constexpr (Shadows) {
+                if (_shadowed(Ray(point, lightDir), distance, view, &pointLight - _lights.data(), cache, tally)) {
+                    return;
                 }
             }
-        }
+            float angle = lightDir.Angle(normal);
+            if (angle > 90.f) {
+                angle = 180.f - angle;
+            }
+            color += (Color(triangle.GetDiffuseColor()) * (((-1.f / 90.f) * angle + 1.f) * pointLight.Attenuate(distance)));
+        });
         return color;
     }
 
-    Intersection const Engine::_intersect(Ray const& ray) {
-        Intersection rtn;
-        float min = -1;
+    template <NormalMode Normals, bool Shadows, bool SingleLight>
+    Color Engine::_shade(Ray const& ray) const {
+        LightTally tally;
+        Color const color = _shadeHit<Normals, Shadows, SingleLight>(ray, nullptr, Hit(), false, tally);
+        _addTally(tally);
+        return color;
+    }
 
-        for (size_t i = 0; i < _meshes.size(); ++i) {
-            Intersection inter = _meshes[i]->Intersect(ray);
-            if (inter.Intersect) {
-                if (min == -1 || inter.Dist < min) {
-                    min = inter.Dist;
-                    rtn = inter;
-                }
+    // Counts are gathered per batch, so threads touch the shared counters once per tile
+    template <NormalMode Normals, bool Shadows, bool SingleLight>
+    void Engine::_shadeBatch(RayBuffer const& rays, VisibilitySample const* visibility, std::vector<Color>& colors) const {
+        LightTally tally;
+        VisibilityTally visible;
+        Roots const roots = _cullTile(rays);
+        colors.resize(rays.Size());
+        for (std::size_t i = 0; i < rays.Size(); ++i) {
+            Ray const ray = rays.GetRay(i);
+            Hit hit;
+            bool const settled = visibility != nullptr && _seedHit(ray, visibility[i], hit, visible);
+            colors[i] = _shadeHit<Normals, Shadows, SingleLight>(ray, roots, hit, settled, tally);
+        }
+        _addTally(tally);
+        if (visibility != nullptr) {
+            _addVisibility(visible);
+        }
+    }
+
+    template <NormalMode Normals, bool Shadows, bool SingleLight>
+    void Engine::_setKernels() {
+        _kernel = &Engine::_shade<Normals, Shadows, SingleLight>;
+        _batchKernel = &Engine::_shadeBatch<Normals, Shadows, SingleLight>;
+    }
+
+    Color Engine::_shadeAO(Ray const& ray) const {
+        LodView const view = _lodView(ray);
+        Hit hit;
+        if (!_closestHit(ray, view, nullptr, hit)) {
+            return Color();
+        }
+        Vector3<float> const point = ray.Origin + ray.Direction * hit.Dist;
+        Hemisphere const hemisphere(_triangles[hit.Slot].GetNormal(), ray.Direction);
+        std::uint32_t const seed = raySeed(ray);
+        unsigned int visible = 0;
+        for (unsigned int sample = 0; sample < _ao.Samples; ++sample) {
+            visible += !_occluded(Ray(point, hemisphere.Sample(seed, sample)), _ao.Distance, view);
+        }
+        _aoRays.Add(_ao.Samples);
+        return Color(Vector3<float>(1.f, 1.f, 1.f) * (static_cast<float>(visible) / _ao.Samples));
+    }
+
+    // Traces the primary rays first, then all occlusion rays of the batch in one any-hit pass
+    void Engine::_shadeAOBatch(RayBuffer const& rays, VisibilitySample const* visibility, std::vector<Color>& colors) const {
+        thread_local AOBatch batch;
+        VisibilityTally visible;
+        Roots const roots = _cullTile(rays);
+        colors.assign(rays.Size(), Color());
+        batch.Pixels.clear();
+        batch.Rays.clear();
+        batch.Owners.clear();
+        for (std::size_t i = 0; i < rays.Size(); ++i) {
+            Ray const ray = rays.GetRay(i);
+            Hit hit;
+            bool const settled = visibility != nullptr && _seedHit(ray, visibility[i], hit, visible);
+            if (settled ? hit.Slot == RayHit::NoHit : !_closestHit(ray, _lodView(ray), roots, hit)) {
+                continue;
+            }
+            Vector3<float> const point = ray.Origin + ray.Direction * hit.Dist;
+            Hemisphere const hemisphere(_triangles[hit.Slot].GetNormal(), ray.Direction);
+            std::uint32_t const seed = raySeed(ray);
+            std::uint32_t const owner = static_cast<std::uint32_t>(batch.Pixels.size());
+            batch.Pixels.push_back(static_cast<std::uint32_t>(i));
+            for (unsigned int sample = 0; sample < _ao.Samples; ++sample) {
+                batch.Rays.emplace_back(point, hemisphere.Sample(seed, sample));
+                batch.Owners.push_back(owner);
             }
         }
-        return rtn;
+
+        batch.Visible.assign(batch.Pixels.size(), 0);
+        for (std::size_t i = 0; i < batch.Rays.size(); ++i) {
+            LodView const view = _lodView(rays.GetRay(batch.Pixels[batch.Owners[i]]));
+            batch.Visible[batch.Owners[i]] += !_occluded(batch.Rays[i], _ao.Distance, view);
+        }
+        _aoRays.Add(batch.Rays.size());
+        if (visibility != nullptr) {
+            _addVisibility(visible);
+        }
+
+        for (std::size_t i = 0; i < batch.Pixels.size(); ++i) {
+            colors[batch.Pixels[i]] = Color(Vector3<float>(1.f, 1.f, 1.f) * (static_cast<float>(batch.Visible[i]) / _ao.Samples));
+        }
+    }
+
+    void Engine::_selectKernels() {
+        if (_ao.Samples > 0) {
+            _kernel = &Engine::_shadeAO;
+            _batchKernel = &Engine::_shadeAOBatch;
+            return;
+        }
+        // One instantiation per combination, picked here instead of tested per ray
+        using Setter = void (Engine::*)();
+        static Setter const setters[3][2][2] = {
+            {{&Engine::_setKernels<NormalMode::Flat, false, false>, &Engine::_setKernels<NormalMode::Flat, false, true>},
+             {&Engine::_setKernels<NormalMode::Flat, true, false>, &Engine::_setKernels<NormalMode::Flat, true, true>}},
+            {{&Engine::_setKernels<NormalMode::Smooth, false, false>, &Engine::_setKernels<NormalMode::Smooth, false, true>},
+             {&Engine::_setKernels<NormalMode::Smooth, true, false>, &Engine::_setKernels<NormalMode::Smooth, true, true>}},
+            {{&Engine::_setKernels<NormalMode::PerTriangle, false, false>, &Engine::_setKernels<NormalMode::PerTriangle, false, true>},
+             {&Engine::_setKernels<NormalMode::PerTriangle, true, false>, &Engine::_setKernels<NormalMode::PerTriangle, true, true>}},
+        };
+        (this->*setters[static_cast<int>(_features.Normals)][_features.Shadows][_features.SingleLight])();
     }
 
     Vector2<unsigned int> Engine::GetRes() const {
@@ -1,31 +1,343 @@
 #pragma once
 
-#include <memory>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <vector>
+#include "../Accel/BVH.h"
+#include "../Accel/WideBVH.h"
 #include "../Camera/Camera.h"
-#include "../Loader/AssimpLoader.h"
+#include "../Scene/Scene.h"
 #include "../Vector/Vector2.h"
 #include "../Vector/Vector3.h"
 #include "Color.h"
+#include "Counter.h"
+#include "Span.h"
 #include "Tools.h"
 
 namespace rt {
+    enum class NormalMode {
+        Flat,
+        Smooth,
+        // The scene mixes meshes with and without vertex normals, decided per hit
+        PerTriangle
+    };
+
+    // Shading features the kernels are specialized on, fixed when the scene is loaded
+    struct ShadingFeatures {
+        NormalMode  Normals = NormalMode::Flat;
+        bool        Shadows = true;
+        bool        SingleLight = false;
+    };
+
+    struct AOOptions {
+        // Occlusion rays per primary hit, 0 shades with the lights instead
+        unsigned int    Samples = 0;
+        // Occluders farther than this from the hit do not count
+        float           Distance = 1.f;
+    };
+
+    // The switches a render sets on an engine after building it, as the command line gives them.
+    // Cluster jobs and the render server carry them so their images match a batch run.
+    struct ShadingOptions {
+        bool            Shadows = true;
+        bool            OccluderCache = true;
+        bool            TileCulling = true;
+        float           LightRadius = 0.f;
+        AOOptions       AO;
+    };
+
+    // Result of a batch intersection query. Primitive indexes the triangles of the scene the
+    // engine was built from, NoHit when the ray missed. Normal is the geometric normal.
+    struct RayHit {
+        static constexpr std::uint32_t NoHit = std::numeric_limits<std::uint32_t>::max();
+
+        float           Dist = std::numeric_limits<float>::infinity();
+        std::uint32_t   Primitive = NoHit;
+        float           U = 0.f;
+        float           V = 0.f;
+        Vector3<float>  Normal;
+    };
+
+    // A camera ray's entry in a visibility buffer: the slot of the triangle a rasterizer found
+    // nearest along it, RayHit::NoHit when none, and whether no other triangle can be nearer
+    struct VisibilitySample {
+        std::uint32_t   Slot = RayHit::NoHit;
+        bool            Settled = false;
+    };
+
     class Engine {
     public:
-        explicit    Engine(AssimpLoader const& loader);
+        // Takes the scene's triangles into leaf order and frees the rest of it
+        explicit    Engine(Scene&& scene, AccelOptions const& accel = AccelOptions());
 
         Engine(const Engine& engine) = default;
 
         Color                   Raytrace(Vector2<unsigned int> const& pixel);
+        Color                   Raytrace(Ray const& ray) const;
+        void                    Raytrace(RayBuffer const& rays, std::vector<Color>& colors) const;
+        // Same, with visibility[i] describing rays[i]. A settled sample is the hit, while the triangle
+        // of any other one the ray meets bounds its traversal, so the hits and the image stay the same.
+        void                    Raytrace(RayBuffer const& rays, Span<VisibilitySample const> visibility, std::vector<Color>& colors) const;
+
+        // Batch queries for code other than the renderers. They are const and thread safe, so
+        // batches may be traced from several threads at once; the shorter span bounds the batch.
+        void                    IntersectBatch(Span<Ray const> rays, Span<RayHit> hits) const;
+        // occluded[i] becomes 1 when a triangle lies along rays[i] no farther than maxDistances[i]
+        void                    OccludedBatch(Span<Ray const> rays, Span<float const> maxDistances, Span<std::uint8_t> occluded) const;
         Vector2<unsigned int>   GetRes() const;
         Camera*                 GetCamera() { return &_camera; }
+        Camera const*           GetCamera() const { return &_camera; }
+        BVHStats const&         GetBVHStats() const { return _bvh.GetStats(); }
+        WideBVHStats const&     GetWideBVHStats() const { return _accel.Width == 8 ? _bvh8.GetStats() : _bvh4.GetStats(); }
+        AccelOptions const&     GetAccelOptions() const { return _accel; }
+        ShadingFeatures const&  GetShadingFeatures() const { return _features; }
+        // Slots a camera ray from eye may hit: every triangle outside levels of detail, and the
+        // triangles of the level each object is traced at from there. A triangle spatial splits
+        // copied into several slots appears once, at the lowest, since a ray meets every copy alike.
+        void                    GetCameraSlots(Vector3<float> const& eye, std::vector<std::uint32_t>& slots) const;
+        Triangle const&         GetTriangle(std::uint32_t slot) const { return _triangles[slot]; }
+        // Applies every switch of shading through the setters below
+        void                    SetShading(ShadingOptions const& shading);
+        // Selects the kernel without shadow rays, or back
+        void                    SetShadows(bool shadows);
+        // Tests the last triangle that blocked each light on this thread before traversing shadow rays
+        void                    SetOccluderCache(bool enabled) { _cacheOccluders = enabled; }
+        // Overrides the cutoff radius of every light, 0 restores the radii from their attenuation
+        void                    SetLightRadius(float radius);
+        // Traces each object with levels of detail at the coarsest one whose error stays below
+        // errorPerDistance times the object's distance from the camera. 0, the default, traces
+        // the full meshes, which the batch queries always do.
+        void                    SetLevelOfDetail(float errorPerDistance) { _lodScale = errorPerDistance; }
+        void                    ReportLods(std::ostream& out) const;
+        // Starts the camera rays of each batch from the subtrees of the hierarchy inside the
+        // batch's frustum instead of the root. On by default.
+        void                    SetTileCulling(bool enabled) { _cullTiles = enabled; }
+        // Batches culled, and the subtrees their camera rays started from
+        Counter const&          GetCulledTiles() const { return _culledTiles; }
+        Counter const&          GetTileRoots() const { return _tileRoots; }
+        void                    ReportCulling(std::ostream& out) const;
+        // Rays traced with a visibility buffer, those that met the triangle of their sample, and
+        // those whose sample was settled and left nothing to traverse
+        Counter const&          GetRasterRays() const { return _rasterRays; }
+        Counter const&          GetRasterSeeded() const { return _rasterSeeded; }
+        Counter const&          GetRasterSettled() const { return _rasterSettled; }
+        void                    ReportVisibility(std::ostream& out) const;
+        // Replaces light shading with ambient occlusion while ao.Samples > 0
+        void                    SetAmbientOcclusion(AOOptions const& ao);
+        // Occlusion rays traced by the ambient occlusion kernels since construction or the last reset
+        Counter const&          GetAORays() const { return _aoRays; }
+        void                    ReportAO(float milliseconds, std::ostream& out) const;
+        // Lights considered at the shaded hits, and those skipped because the hit lies beyond their radius
+        Counter const&          GetLightEvaluations() const { return _lightEvaluations; }
+        Counter const&          GetCulledLights() const { return _culledLights; }
+        // Shadow rays traced by the lit kernels, and those answered by the cached occluder
+        Counter const&          GetShadowRays() const { return _shadowRays; }
+        Counter const&          GetOccluderCacheHits() const { return _occluderCacheHits; }
+        void                    ReportLights(std::ostream& out) const;
+        void                    ReportKernel(std::ostream& out) const;
+        // Adds every counter of other, such as a copy traced alongside this engine, to this one's
+        void                    AddCounters(Engine const& other) const;
+        void                    ResetCounters() const;
+        // Traversal work of each camera ray of a tile and of the shadow or occlusion rays the current
+        // kernel traces from its hit, and how many of those were traced. The camera rays start from
+        // the subtrees tile culling leaves them, as Raytrace does; the culling itself is not counted.
+        void                    MeasureCost(RayBuffer const& rays, Span<TraversalCost> primary, Span<TraversalCost> secondary,
+                                            Span<unsigned int> secondaryRays) const;
 
     private:
-        AssimpLoader                        _loader;
+        // Number no other engine of the process carries. Copies and assignments take a fresh one, so
+        // per-thread state keyed on it never applies to a later engine built at the same address.
+        struct Identity {
+            std::uint64_t   Value = Next();
+
+            Identity() = default;
+            Identity(Identity const&) : Value(Next()) {}
+            Identity&       operator=(Identity const&) {
+                Value = Next();
+                return *this;
+            }
+
+            static std::uint64_t    Next();
+        };
+
+        Identity                            _identity;
         Camera                              _camera;
-        std::vector<std::shared_ptr<Object>>_meshes;
-        std::vector<std::shared_ptr<PointLight>> _lights;
+        // Unbounded lights first, then the bounded ones in the leaf order of _lightBVH
+        std::vector<PointLight>             _lights;
+        std::size_t                         _unboundedLights = 0;
+        BVH                                 _lightBVH;
+        LargeArray<Triangle>                _triangles;
+        AccelOptions                        _accel;
+        BVH                                 _bvh;
+        WideBVH<4>                          _bvh4;
+        WideBVH<8>                          _bvh8;
+        ShadingFeatures                     _features;
+        AOOptions                           _ao;
+        Counter                             _aoRays;
+        Counter                             _lightEvaluations;
+        Counter                             _culledLights;
+        Counter                             _shadowRays;
+        Counter                             _occluderCacheHits;
+        Counter                             _culledTiles;
+        Counter                             _tileRoots;
+        Counter                             _emptyTiles;
+        Counter                             _rasterRays;
+        Counter                             _rasterSeeded;
+        Counter                             _rasterSettled;
+        bool                                _cacheOccluders = true;
+        bool                                _cullTiles = true;
+        Color               (Engine::*_kernel)(Ray const& ray) const = nullptr;
+        void                (Engine::*_batchKernel)(RayBuffer const& rays, VisibilitySample const* visibility,
+                                                    std::vector<Color>& colors) const = nullptr;
+
+        struct Hit {
+            std::uint32_t   Slot = RayHit::NoHit;
+            float           Dist = 0.f;
+            float           U = 0.f;
+            float           V = 0.f;
+        };
+
+        struct LightTally {
+            std::size_t     Evaluations = 0;
+            std::size_t     Shaded = 0;
+            std::size_t     ShadowRays = 0;
+            std::size_t     CacheHits = 0;
+        };
+
+        struct VisibilityTally {
+            std::size_t     Rays = 0;
+            std::size_t     Seeded = 0;
+            std::size_t     Settled = 0;
+        };
+
+        // The levels of an object follow each other in _lodLevels, their triangles in _triangles
+        struct LodLevel {
+            BVH             Bvh;
+            WideBVH<4>      Bvh4;
+            WideBVH<8>      Bvh8;
+            std::uint32_t   FirstSlot = 0;
+            std::uint32_t   Object = 0;
+            float           Error = 0.f;
+        };
+
+        struct LodObject {
+            AABB            Bounds;
+            std::uint32_t   FirstLevel = 0;
+            std::uint32_t   LevelCount = 0;
+        };
+
+        // Levels a ray path sees. Shadow and occlusion rays keep the view of their camera ray, so
+        // they meet the same surface the camera ray hit. Scale 0 selects the full meshes.
+        struct LodView {
+            Vector3<float>  Apex;
+            float           Scale = 0.f;
+        };
+
+        // Objects with levels of detail take one proxy slot each in the scene hierarchy, _proxies
+        // maps its slots to _lodObjects and _primitives all slots to the scene's triangles
+        std::vector<LodObject>              _lodObjects;
+        std::vector<LodLevel>               _lodLevels;
+        std::vector<std::uint32_t>          _proxies;
+        std::vector<std::uint32_t>          _primitives;
+        float                               _lodScale = 0.f;
+
+        using Roots = std::vector<TraversalRoot> const*;
 
         void                _pathtrace(Ray const& ray, unsigned int const& depth, Color & color);
-        Intersection const  _intersect(Ray const& ray);
+        // An optional TraversalCost argument counts the work done
+        // Roots, when not null, come from _cullTile for a batch holding the ray. A hit passed in
+        // holding a triangle the ray meets bounds the traversal, without changing the result.
+        template <class... Cost>
+        bool                _closestHit(Ray const& ray, LodView const& view, Roots roots, Hit& hit, Cost&... cost) const;
+        template <class... Cost>
+        bool                _occluded(Ray const& ray, float maxDistance, LodView const& view, Cost&... cost) const;
+        // Slot of the first triangle found within maxDistance, RayHit::NoHit if there is none
+        template <class... Cost>
+        std::uint32_t       _occluder(Ray const& ray, float maxDistance, LodView const& view, Cost&... cost) const;
+        // Shadow test towards _lights[light], trying the occluder cache first when cache is not null
+        template <class... Cost>
+        bool                _shadowed(Ray const& ray, float distance, LodView const& view, std::size_t light,
+                                      std::uint32_t* cache, LightTally& tally, Cost&... cost) const;
+        LodView             _lodView(Ray const& ray) const { return LodView{ray.Origin, _lodScale}; }
+        // Index into _lodLevels of the level the view traces the object at
+        std::uint32_t       _selectLevel(std::uint32_t object, LodView const& view) const;
+        // Whether the view traverses the hierarchy holding the slot
+        bool                _inView(std::uint32_t slot, LodView const& view) const;
+        // Sets hit to the sample's triangle when the ray meets it. True when the sample settles the
+        // ray, leaving hit as the closest hit, or without a slot for a miss.
+        bool                _seedHit(Ray const& ray, VisibilitySample const& sample, Hit& hit, VisibilityTally& tally) const;
+        void                _addVisibility(VisibilityTally const& tally) const;
+        // This thread's subtrees inside the frustum of the batch, null when its rays do not share an origin
+        Roots               _cullTile(RayBuffer const& rays) const;
+        unsigned int        _measureCost(Ray const& ray, Roots roots, TraversalCost& primary, TraversalCost& secondary) const;
+        // This thread's last occluder per light, null while the cache is disabled
+        std::uint32_t*      _occluderCache() const;
+
+        template <bool SingleLight, class Shade>
+        void                _forEachLight(Vector3<float> const& point, LightTally& tally, Shade&& shade) const;
+        void                _addTally(LightTally const& tally) const;
+        void                _buildLightBVH(ThreadPool& pool);
+        std::array<Counter const*, 11>  _counters() const;
+
+        template <NormalMode Normals, bool Shadows, bool SingleLight>
+        // Shades the closest hit, traced unless settled says hit already is the closest
+        Color               _shadeHit(Ray const& ray, Roots roots, Hit hit, bool settled, LightTally& tally) const;
+        template <NormalMode Normals, bool Shadows, bool SingleLight>
+        Color               _shade(Ray const& ray) const;
+        template <NormalMode Normals, bool Shadows, bool SingleLight>
+        void                _shadeBatch(RayBuffer const& rays, VisibilitySample const* visibility, std::vector<Color>& colors) const;
+        template <NormalMode Normals, bool Shadows, bool SingleLight>
+        void                _setKernels();
+        Color               _shadeAO(Ray const& ray) const;
+        void                _shadeAOBatch(RayBuffer const& rays, VisibilitySample const* visibility, std::vector<Color>& colors) const;
+        void                _selectKernels();
+        // Builds the wide hierarchy of the selected width from bvh, whose nodes are then freed
+        void                _collapse(BVH& bvh, WideBVH<4>& bvh4, WideBVH<8>& bvh8) const;
+
+        template <class Visit, class... Cost>
+        void                _traverseHierarchy(BVH const& bvh, WideBVH<4> const& bvh4, WideBVH<8> const& bvh8, Ray const& ray,
+                                               float tMax, Roots roots, Visit&& visit, Cost&... cost) const {
+            if (roots != nullptr) {
+                if (_accel.Width == 8) {
+                    bvh8.TraverseFrom(*roots, ray, tMax, visit, cost...);
+                } else if (_accel.Width == 4) {
+                    bvh4.TraverseFrom(*roots, ray, tMax, visit, cost...);
+                } else {
+                    bvh.TraverseFrom(*roots, ray, tMax, visit, cost...);
+                }
+            } else if (_accel.Width == 8) {
+                bvh8.Traverse(ray, tMax, visit, cost...);
+            } else if (_accel.Width == 4) {
+                bvh4.Traverse(ray, tMax, visit, cost...);
+            } else {
+                bvh.Traverse(ray, tMax, visit, cost...);
+            }
+        }
+
+        // A proxy slot traverses its object's selected level in place, with the same tMax. Roots
+        // only apply to the scene hierarchy.
+        template <class Visit, class... Cost>
+        void                _traverse(Ray const& ray, float tMax, LodView const& view, Roots roots, Visit&& visit, Cost&... cost) const {
+            if (_lodObjects.empty()) {
+                _traverseHierarchy(_bvh, _bvh4, _bvh8, ray, tMax, roots, visit, cost...);
+                return;
+            }
+            _traverseHierarchy(_bvh, _bvh4, _bvh8, ray, tMax, roots, [&](std::uint32_t slot, float& sceneMax) {
+                std::uint32_t const object = _proxies[slot];
+                if (object == RayHit::NoHit) {
+                    return visit(slot, sceneMax);
+                }
+                LodLevel const& level = _lodLevels[_selectLevel(object, view)];
+                bool stop = false;
+                _traverseHierarchy(level.Bvh, level.Bvh4, level.Bvh8, ray, sceneMax, nullptr, [&](std::uint32_t local, float& levelMax) {
+                    stop = visit(level.FirstSlot + local, levelMax);
+                    sceneMax = levelMax;
+                    return stop;
+                }, cost...);
+                return stop;
+            }, cost...);
+        }
     };
 }  // namespace rt
@@ -0,0 +1,148 @@
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include "Memory.h"
+
+namespace rt {
+    namespace {
+        std::atomic<HugePages> hugePages{HugePages::Off};
+
+        std::size_t roundUp(std::size_t bytes, std::size_t alignment) {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+#if defined(__linux__)
+        // Anonymous mapping of bytes aligned to LargeAllocation, trimming the slack mapped to find the alignment
+        void* mapAligned(std::size_t bytes) {
+            std::size_t const padded = bytes + LargeAllocation;
+            void* const mapping = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED) {
+                return nullptr;
+            }
+            std::uintptr_t const start = reinterpret_cast<std::uintptr_t>(mapping);
+            std::uintptr_t const aligned = roundUp(start, LargeAllocation);
+            if (aligned > start) {
+                munmap(mapping, aligned - start);
+            }
+            std::size_t const tail = start + padded - (aligned + bytes);
+            if (tail > 0) {
+                munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+            }
+            return reinterpret_cast<void*>(aligned);
+        }
+#endif
+    }
+
+    void SetHugePages(HugePages mode) {
+        hugePages.store(mode, std::memory_order_relaxed);
+    }
+
+    HugePages GetHugePages() {
+        return hugePages.load(std::memory_order_relaxed);
+    }
+
+    char const* GetName(HugePages mode) {
+        switch (mode) {
+            case HugePages::Off:
+                return "off";
+            case HugePages::Transparent:
+                return "transparent";
+            case HugePages::Explicit:
+                return "explicit";
+        }
+        return "unknown";
+    }
+
+    void* AllocateLarge(std::size_t bytes, std::size_t alignment) {
+#if defined(__linux__)
+        if (bytes >= LargeAllocation) {
+            std::size_t const size = roundUp(bytes, LargeAllocation);
+            HugePages const mode = GetHugePages();
+            void* data = nullptr;
+            if (mode == HugePages::Explicit) {
+                data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (data != MAP_FAILED) {
+                    return data;
+                }
+            }
+            data = mapAligned(size);
+            if (data == nullptr) {
+                throw std::bad_alloc();
+            }
+            if (mode != HugePages::Off) {
+                madvise(data, size, MADV_HUGEPAGE);
+            }
+            return data;
+        }
+#endif
+        return ::operator new(bytes, std::align_val_t(alignment));
+    }
+
+    void FreeLarge(void* data, std::size_t bytes, std::size_t alignment) {
+#if defined(__linux__)
+        if (bytes >= LargeAllocation) {
+            munmap(data, roundUp(bytes, LargeAllocation));
+            return;
+        }
+#endif
+        ::operator delete(data, std::align_val_t(alignment));
+    }
+
+    MemoryUsage ReadMemoryUsage() {
+        MemoryUsage usage;
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            std::istringstream fields(line);
+            std::string key;
+            std::size_t kilobytes = 0;
+            if (!(fields >> key >> kilobytes)) {
+                continue;
+            }
+            if (key == "VmHWM:") {
+                usage.Peak = kilobytes * 1024;
+            } else if (key == "VmRSS:") {
+                usage.Resident = kilobytes * 1024;
+            }
+        }
+        std::ifstream rollup("/proc/self/smaps_rollup");
+        while (std::getline(rollup, line)) {
+            std::istringstream fields(line);
+            std::string key;
+            std::size_t kilobytes = 0;
+            if ((fields >> key >> kilobytes) && (key == "AnonHugePages:" || key == "Private_Hugetlb:" || key == "Shared_Hugetlb:")) {
+                usage.HugePages += kilobytes * 1024;
+            }
+        }
+        return usage;
+    }
+
+    void ReleaseFreeMemory() {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+    }
+
+    void ReportMemory(std::ostream& out) {
+        MemoryUsage const usage = ReadMemoryUsage();
+        if (usage.Peak == 0) {
+            return;
+        }
+        out << std::fixed << std::setprecision(2) << "Memory: peak " << usage.Peak / (1024.f * 1024.f) << " MiB, steady "
+            << usage.Resident / (1024.f * 1024.f) << " MiB";
+        if (usage.HugePages > 0) {
+            out << ", " << usage.HugePages / (1024.f * 1024.f) << " MiB in huge pages";
+        }
+        out << std::endl;
+    }
+}  // namespace rt
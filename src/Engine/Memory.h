@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace rt {
+    // Process memory as the kernel counts it, in bytes. Zero where /proc is unavailable.
+    struct MemoryUsage {
+        std::size_t     Peak = 0;
+        std::size_t     Resident = 0;
+        // Part of Resident backed by transparent or explicit huge pages
+        std::size_t     HugePages = 0;
+    };
+
+    MemoryUsage     ReadMemoryUsage();
+    // Hands memory freed by loading and building back to the system, so Resident shows the steady state
+    void            ReleaseFreeMemory();
+    void            ReportMemory(std::ostream& out);
+
+    enum class HugePages {
+        // Whatever the system does by default
+        Off,
+        // Transparent huge pages, advised on 2 MiB aligned mappings
+        Transparent,
+        // Pages from the hugetlbfs pool, falling back to transparent ones when it is empty
+        Explicit
+    };
+
+    // Applies to large arrays allocated from now on
+    void            SetHugePages(HugePages mode);
+    HugePages       GetHugePages();
+    char const*     GetName(HugePages mode);
+
+    // Arrays of at least LargeAllocation bytes get their own mapping, aligned and advised per the
+    // huge page mode, and untouched until written so first-touch places them on the writer's node.
+    // Smaller ones come from the heap at the given alignment, which the mappings always meet. The path
+    // depends on the size alone, so freeing needs no bookkeeping beyond passing the same size and alignment.
+    constexpr std::size_t   LargeAllocation = std::size_t(2) << 20;
+
+    void*           AllocateLarge(std::size_t bytes, std::size_t alignment);
+    void            FreeLarge(void* data, std::size_t bytes, std::size_t alignment);
+
+    template <class T>
+    struct LargePageAllocator {
+        using value_type = T;
+
+        LargePageAllocator() = default;
+        template <class U>
+        LargePageAllocator(LargePageAllocator<U> const&) {}
+
+        T*      allocate(std::size_t count) {
+            return static_cast<T*>(AllocateLarge(count * sizeof(T), alignof(T)));
+        }
+
+        void    deallocate(T* data, std::size_t count) {
+            FreeLarge(data, count * sizeof(T), alignof(T));
+        }
+
+        template <class U>
+        bool    operator==(LargePageAllocator<U> const&) const {
+            return true;
+        }
+
+        template <class U>
+        bool    operator!=(LargePageAllocator<U> const&) const {
+            return false;
+        }
+    };
+
+    // Read-mostly scene arrays: triangles and hierarchy nodes
+    template <class T>
+    using LargeArray = std::vector<T, LargePageAllocator<T>>;
+}  // namespace rt
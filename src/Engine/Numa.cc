@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "Memory.h"
+#include "Numa.h"
+
+namespace rt {
+    namespace {
+        // Kernel list format, "0-3,8,10-11"
+        std::vector<unsigned int> parseList(std::string const& text) {
+            std::vector<unsigned int> values;
+            std::istringstream ranges(text);
+            std::string range;
+            while (std::getline(ranges, range, ',')) {
+                if (range.empty() || range[0] < '0' || range[0] > '9') {
+                    continue;
+                }
+                std::size_t const dash = range.find('-');
+                unsigned int const first = static_cast<unsigned int>(std::stoul(range.substr(0, dash)));
+                unsigned int const last = dash == std::string::npos ? first
+                                        : static_cast<unsigned int>(std::stoul(range.substr(dash + 1)));
+                for (unsigned int value = first; value <= last; ++value) {
+                    values.push_back(value);
+                }
+            }
+            return values;
+        }
+
+        std::vector<unsigned int> readList(std::string const& path) {
+            std::ifstream file(path);
+            std::string text;
+            std::getline(file, text);
+            return parseList(text);
+        }
+
+        bool allowed(unsigned int cpu) {
+#if defined(__linux__)
+            static cpu_set_t const mask = []() {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+                    for (unsigned int i = 0; i < CPU_SETSIZE; ++i) {
+                        CPU_SET(i, &set);
+                    }
+                }
+                return set;
+            }();
+            return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &mask);
+#else
+            (void)cpu;
+            return true;
+#endif
+        }
+    }
+
+    std::vector<NumaNode> ReadNumaTopology() {
+        std::vector<NumaNode> nodes;
+        for (unsigned int id : readList("/sys/devices/system/node/online")) {
+            NumaNode node;
+            node.Id = id;
+            for (unsigned int cpu : readList("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist")) {
+                if (allowed(cpu)) {
+                    node.Cpus.push_back(cpu);
+                }
+            }
+            // Memory-only nodes and nodes outside the affinity mask get no workers
+            if (!node.Cpus.empty()) {
+                nodes.push_back(std::move(node));
+            }
+        }
+        if (nodes.empty()) {
+            NumaNode node;
+            for (unsigned int cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+                node.Cpus.push_back(cpu);
+            }
+            nodes.push_back(std::move(node));
+        }
+        return nodes;
+    }
+
+    bool PinThread(std::vector<unsigned int> const& cpus) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (unsigned int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    void ReportNuma(std::vector<NumaNode> const& nodes, std::ostream& out) {
+        out << "NUMA: " << nodes.size() << " node(s)";
+        for (NumaNode const& node : nodes) {
+            out << ", node " << node.Id << " with " << node.Cpus.size() << " CPU(s)";
+        }
+        out << std::endl;
+    }
+
+    EngineReplicas::EngineReplicas(Engine const& engine, std::vector<NumaNode> nodes, unsigned int workers) :
+        _engine(engine), _nodes(std::move(nodes)), _workers(std::max(workers, 1u)) {
+        if (_nodes.size() < 2) {
+            return;
+        }
+        _replicas.resize(_nodes.size());
+        for (std::size_t node = 0; node < _nodes.size(); ++node) {
+            std::thread copier([this, node]() {
+                PinThread(_nodes[node].Cpus);
+                _replicas[node] = std::make_unique<Engine>(_engine);
+                _replicas[node]->ResetCounters();
+            });
+            copier.join();
+        }
+        ReleaseFreeMemory();
+    }
+
+    Engine const& EngineReplicas::For(unsigned int worker) const {
+        return _replicas.empty() ? _engine : *_replicas[NodeOf(worker)];
+    }
+
+    unsigned int EngineReplicas::NodeOf(unsigned int worker) const {
+        if (worker >= _workers) {
+            return 0;
+        }
+        return static_cast<unsigned int>(static_cast<std::size_t>(worker) * _nodes.size() / _workers);
+    }
+
+    void EngineReplicas::PinWorker(unsigned int worker) const {
+        PinThread(_nodes[NodeOf(worker)].Cpus);
+    }
+
+    void EngineReplicas::GatherCounters() const {
+        for (std::unique_ptr<Engine> const& replica : _replicas) {
+            _engine.AddCounters(*replica);
+            replica->ResetCounters();
+        }
+    }
+}  // namespace rt
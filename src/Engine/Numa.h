@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "Engine.h"
+
+namespace rt {
+    struct NumaNode {
+        unsigned int                Id = 0;
+        // CPUs of the node this process may run on
+        std::vector<unsigned int>   Cpus;
+    };
+
+    // Nodes listed under /sys/devices/system/node that hold allowed CPUs, or a single
+    // node with every CPU where the system exposes no topology
+    std::vector<NumaNode>   ReadNumaTopology();
+    // Restricts the calling thread to the given CPUs
+    bool                    PinThread(std::vector<unsigned int> const& cpus);
+    void                    ReportNuma(std::vector<NumaNode> const& nodes, std::ostream& out);
+
+    // Spreads pool workers over the nodes in contiguous, evenly sized groups and keeps one copy of the
+    // engine's read-only data per node. Each copy is made by a thread pinned to its node, so first-touch
+    // places its pages there. With a single node the engine is used as is. The copies count their own
+    // rays, GatherCounters moves those counts into the engine so its reports cover every node.
+    class EngineReplicas {
+    public:
+        EngineReplicas(Engine const& engine, std::vector<NumaNode> nodes, unsigned int workers);
+
+        // Engine local to the worker's node. Threads outside the pool use the first node's copy.
+        Engine const&   For(unsigned int worker) const;
+        unsigned int    NodeOf(unsigned int worker) const;
+        // ThreadPool start hook pinning each worker to its node
+        void            PinWorker(unsigned int worker) const;
+        std::size_t     GetNodeCount() const { return _nodes.size(); }
+        // Adds the counters of the copies to the engine's and clears them
+        void            GatherCounters() const;
+
+    private:
+        Engine const&                           _engine;
+        std::vector<NumaNode>                   _nodes;
+        unsigned int                            _workers;
+        std::vector<std::unique_ptr<Engine>>    _replicas;
+    };
+}  // namespace rt
@@ -0,0 +1,38 @@
+#include <iomanip>
+#include "Profiler.h"
+
+namespace rt {
+    namespace {
+        const char* const SectionNames[Profiler::SectionCount] = {
+            "trace",
+            "copy",
+            "upload"
+        };
+    }
+
+    Profiler::Profiler() {
+        Reset();
+    }
+
+    void Profiler::Add(Section section, std::chrono::steady_clock::duration elapsed) {
+        _nanoseconds[section].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+        _calls[section].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Profiler::Reset() {
+        for (std::size_t i = 0; i < SectionCount; ++i) {
+            _nanoseconds[i].store(0, std::memory_order_relaxed);
+            _calls[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Profiler::Report(std::ostream& out) const {
+        for (std::size_t i = 0; i < SectionCount; ++i) {
+            std::uint64_t calls = _calls[i].load(std::memory_order_relaxed);
+            double total = _nanoseconds[i].load(std::memory_order_relaxed) / 1e6;
+            out << std::setw(8) << SectionNames[i] << ": " << std::fixed << std::setprecision(3)
+                << total << " ms total, " << calls << " frames, "
+                << (calls ? total / calls : 0.0) << " ms/frame" << std::endl;
+        }
+    }
+}  // namespace rt
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace rt {
+    class Profiler {
+    public:
+        enum Section : std::size_t {
+            Trace,
+            Copy,
+            Upload,
+            SectionCount
+        };
+
+        class Scope {
+        public:
+            Scope(Profiler& profiler, Section section) : _profiler(profiler), _section(section),
+                _start(std::chrono::steady_clock::now()) {};
+            ~Scope() {
+                _profiler.Add(_section, std::chrono::steady_clock::now() - _start);
+            }
+
+        private:
+            Profiler&                                   _profiler;
+            Section                                     _section;
+            std::chrono::steady_clock::time_point       _start;
+        };
+
+        Profiler();
+
+        void    Add(Section section, std::chrono::steady_clock::duration elapsed);
+        void    Reset();
+        void    Report(std::ostream& out) const;
+
+    private:
+        std::array<std::atomic<std::uint64_t>, SectionCount>    _nanoseconds;
+        std::array<std::atomic<std::uint64_t>, SectionCount>    _calls;
+    };
+}  // namespace rt
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace rt {
+    // Non-owning view of contiguous elements, the subset of std::span the batch queries need
+    template <class T>
+    class Span {
+    public:
+        Span() = default;
+        Span(T* data, std::size_t size) : _data(data), _size(size) {}
+        template <class U, class = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+        Span(std::vector<U>& values) : _data(values.data()), _size(values.size()) {}
+        template <class U, class = std::enable_if_t<std::is_convertible_v<U const(*)[], T(*)[]>>>
+        Span(std::vector<U> const& values) : _data(values.data()), _size(values.size()) {}
+
+        T*              Data() const { return _data; }
+        std::size_t     Size() const { return _size; }
+        bool            Empty() const { return _size == 0; }
+        T&              operator[](std::size_t index) const { return _data[index]; }
+        T*              begin() const { return _data; }
+        T*              end() const { return _data + _size; }
+
+        Span            Subspan(std::size_t offset, std::size_t count) const { return Span(_data + offset, count); }
+
+    private:
+        T*              _data = nullptr;
+        std::size_t     _size = 0;
+    };
+}  // namespace rt
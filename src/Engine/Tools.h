@@ -3,6 +3,16 @@
 #include "../Vector/Vector3.h"
 
 namespace rt {
+    struct Tile {
+        Tile(): X(0), Y(0), Width(0), Height(0) {};
+        Tile(unsigned int x, unsigned int y, unsigned int width, unsigned int height): X(x), Y(y), Width(width), Height(height) {};
+
+        unsigned int    X;
+        unsigned int    Y;
+        unsigned int    Width;
+        unsigned int    Height;
+    };
+
     struct Ray {
         Ray(): Origin(), Direction() {};
         Ray(Vector3<float> const& origin, Vector3<float> const& dir): Origin(origin), Direction(dir) {};
@@ -28,39 +28,26 @@ namespace rt {
         this->generateCharacteristics();
     }
 
-    Intersection const Triangle::Intersect(Ray const& ray) {
+    Intersection const Triangle::Intersect(Ray const& ray) const {
         Intersection ret;
-        Vector3<float> pvec = ray.Direction.Cross(_edge2);
-        float det = _edge1.Dot(pvec);
-        if (det > -Constant::Epsilon && det < Constant::Epsilon) {
-            return ret;
-        }
-        Vector3<float> tvec = ray.Origin - _v1.GetPos();
-        float u = tvec.Dot(pvec) / det;
-        if (u < 0.f || u > 1.f) {
-            return ret;
-        }
-        Vector3<float> qvec = tvec.Cross(_edge1);
-        float v = ray.Direction.Dot(qvec) / det;
-        if (v < 0.f || u + v > 1.f) {
-            return ret;
-        }
-        float t = _edge2.Dot(qvec) / det;
-        if (t < Constant::MinDist) {
+        float t;
+        float u;
+        float v;
+        if (!Hit(ray, t, u, v)) {
             return ret;
         }
         ret.Intersect = true;
         ret.Point = ray.Origin + ray.Direction * t;
         ret.Dist = t;
-        if (_v1.GetNormal() != Vector3<float>()) {
-            ret.Normal = _v1.GetNormal() * (1 - u - v) + _v2.GetNormal() * u + _v3.GetNormal() * v;
-        } else {
-            ret.Normal = _normal;
-        }
+        ret.Normal = HasVertexNormals() ? GetNormalAt<true>(u, v) : GetNormalAt<false>(u, v);
         ret.DiffuseColor = _diffuseColor;
         return ret;
     }
 
+    bool Triangle::HasVertexNormals() const {
+        return _v1.GetNormal() != Vector3<float>();
+    }
+
    Vertex const& Triangle::GetV1() const {
        return _v1;
    }
@@ -77,31 +64,14 @@ namespace rt {
        return _normal;
    }
 
+   Vector3<float> const& Triangle::GetDiffuseColor() const {
+       return _diffuseColor;
+   }
+
     void Triangle::generateCharacteristics() {
         _edge1 = _v2.GetPos() - _v1.GetPos();
         _edge2 = _v3.GetPos() - _v1.GetPos();
         _normal = _edge1.Cross(_edge2);
         _normal.Normalize();
     }
-
-    Object::Object(std::vector<Triangle> const& triangles, Vector3<float> const& diffuseColor) : _triangles(triangles) {
-        _diffuseColor = diffuseColor;
-    }
-
-    Intersection const Object::Intersect(Ray const& ray) {
-        Intersection intersection = Intersection();
-        Intersection inter;
-        float min = -1;
-        for (std::size_t i = 0; i < _triangles.size(); ++i) {
-            inter = _triangles[i].Intersect(ray);
-            if (inter.Intersect) {
-                if (min == -1 || inter.Dist < min) {
-                    min = inter.Dist;
-                    intersection = inter;
-                }
-            }
-        }
-        intersection.DiffuseColor = _diffuseColor;
-        return intersection;
-    }  
 }  // namespace rt
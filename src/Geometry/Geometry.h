@@ -3,6 +3,7 @@
 #include <vector>
 #include "../Vector/Vector3.h"
 #include "../Vector/Vector3.h"
+#include "../Engine/Constant.h"
 #include "../Engine/Tools.h"
 
 namespace rt
@@ -25,12 +26,19 @@ namespace rt
       Triangle(Vertex const &v1, Vertex const &v2, Vertex const &v3);
       Triangle(Vertex const &v1, Vertex const &v2, Vertex const &v3, Vector3<float> const &diffuseColor);
 
-      Intersection const Intersect(Ray const &ray);
+      Intersection const Intersect(Ray const &ray) const;
+      // Distance and barycentrics of a hit, without the shading attributes
+      bool Hit(Ray const &ray, float &t, float &u, float &v) const;
+      // Smooth interpolates vertex normals, otherwise the face normal is used
+      template <bool Smooth>
+      Vector3<float> GetNormalAt(float u, float v) const;
+      bool HasVertexNormals() const;
 
       Vertex const &GetV1() const;
       Vertex const &GetV2() const;
       Vertex const &GetV3() const;
       Vector3<float> const &GetNormal() const;
+      Vector3<float> const &GetDiffuseColor() const;
 
    private:
       Vertex _v1;
@@ -43,15 +51,35 @@ namespace rt
 
       void generateCharacteristics();
    };
-   class Object
-   {
-   public:
-      Object(std::vector<Triangle> const &triangles, Vector3<float> const &diffuseColor);
 
-      Intersection const Intersect(Ray const &ray);
+   inline bool Triangle::Hit(Ray const &ray, float &t, float &u, float &v) const
+   {
+      Vector3<float> pvec = ray.Direction.Cross(_edge2);
+      float det = _edge1.Dot(pvec);
+      if (det > -Constant::Epsilon && det < Constant::Epsilon) {
+         return false;
+      }
+      Vector3<float> tvec = ray.Origin - _v1.GetPos();
+      u = tvec.Dot(pvec) / det;
+      if (u < 0.f || u > 1.f) {
+         return false;
+      }
+      Vector3<float> qvec = tvec.Cross(_edge1);
+      v = ray.Direction.Dot(qvec) / det;
+      if (v < 0.f || u + v > 1.f) {
+         return false;
+      }
+      t = _edge2.Dot(qvec) / det;
+      return t >= Constant::MinDist;
+   }
 
-   private:
-      std::vector<Triangle> _triangles;
-      Vector3<float> _diffuseColor;
-   };
+   template <bool Smooth>
+   inline Vector3<float> Triangle::GetNormalAt(float u, float v) const
+   {
+      if constexpr (Smooth) {
+         return _v1.GetNormal() * (1 - u - v) + _v2.GetNormal() * u + _v3.GetNormal() * v;
+      } else {
+         return _normal;
+      }
+   }
 } // namespace rt
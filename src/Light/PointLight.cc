@@ -1,12 +1,17 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "PointLight.h"
 
 namespace rt {
 
     PointLight::PointLight(Vector3<float> const& pos): _pos(pos), _color(0xffffffff), _intensity(1.f) {
+        _radius = _cutoffRadius();
     }
-    
-    PointLight::PointLight(Vector3<float> const& pos, Color const& color): _pos(pos) {
-        _color = color;
+
+    PointLight::PointLight(Vector3<float> const& pos, Color const& color, float intensity, Attenuation const& attenuation):
+        _pos(pos), _color(color), _intensity(intensity), _attenuation(attenuation) {
+        _radius = _cutoffRadius();
     }
 
     Color const& PointLight::GetColor() const {
@@ -17,7 +22,51 @@ namespace rt {
         return _intensity;
     }
 
+    Attenuation const& PointLight::GetAttenuation() const {
+        return _attenuation;
+    }
+
     Vector3<float> PointLight::GetPos() const {
         return _pos;
     }
-}  //namespace rt
+
+    float PointLight::GetRadius() const {
+        return _radius;
+    }
+
+    void PointLight::SetRadius(float radius) {
+        _radius = radius > 0.f ? radius : _cutoffRadius();
+    }
+
+    bool PointLight::IsBounded() const {
+        return _radius != std::numeric_limits<float>::infinity();
+    }
+
+    float PointLight::Attenuate(float distance) const {
+        if (distance >= _radius) {
+            return 0.f;
+        }
+        float const falloff = _intensity / std::max(_attenuation.Constant + _attenuation.Linear * distance
+                                                    + _attenuation.Quadratic * distance * distance, 1e-6f);
+        // (1 - (d / r)^4)^2 window (Karis 2013), 1 for unbounded lights
+        float const ratio = distance / _radius;
+        float const window = 1.f - ratio * ratio * ratio * ratio;
+        return falloff * window * window;
+    }
+
+    // Distance at which the unwindowed falloff drops to Cutoff
+    float PointLight::_cutoffRadius() const {
+        float const reach = _intensity / Cutoff - _attenuation.Constant;
+        if (reach <= 0.f) {
+            return 0.f;
+        }
+        if (_attenuation.Quadratic > 0.f) {
+            float const linear = _attenuation.Linear;
+            return (std::sqrt(linear * linear + 4.f * _attenuation.Quadratic * reach) - linear) / (2.f * _attenuation.Quadratic);
+        }
+        if (_attenuation.Linear > 0.f) {
+            return reach / _attenuation.Linear;
+        }
+        return std::numeric_limits<float>::infinity();
+    }
+}  // namespace rt
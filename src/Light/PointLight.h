@@ -4,18 +4,43 @@
 #include "../Vector/Vector3.h"
 
 namespace rt {
+    // Distance falloff 1 / (Constant + Linear * d + Quadratic * d^2), as stored by Collada and Assimp
+    struct Attenuation {
+        float   Constant = 1.f;
+        float   Linear = 0.f;
+        float   Quadratic = 0.f;
+    };
+
     class PointLight {
      public:
         PointLight(Vector3<float> const& pos);
-        PointLight(Vector3<float> const& pos, Color const& color);
+        PointLight(Vector3<float> const& pos, Color const& color, float intensity = 1.f,
+                   Attenuation const& attenuation = Attenuation());
 
         Vector3<float>          GetPos() const;
         Color const&            GetColor() const;
         float const&            GetBrightness() const;
+        Attenuation const&      GetAttenuation() const;
+        // Distance beyond which the light contributes nothing, infinite without distance falloff
+        float                   GetRadius() const;
+        // Overrides the cutoff radius, 0 restores the one derived from the attenuation
+        void                    SetRadius(float radius);
+        bool                    IsBounded() const;
+
+        // Intensity reaching a point at the given distance. The falloff is windowed so it reaches
+        // zero at the radius smoothly, and culling lights beyond it changes no pixel.
+        float                   Attenuate(float distance) const;
+
+        // Fraction of the intensity below which a light is considered out of reach
+        static constexpr float  Cutoff = 1.f / 256.f;
 
      private:
         Vector3<float>  _pos;
-        Color   _color;
-        float   _intensity;
+        Color           _color;
+        float           _intensity;
+        Attenuation     _attenuation;
+        float           _radius;
+
+        float           _cutoffRadius() const;
     };
-}
\ No newline at end of file
+}  // namespace rt
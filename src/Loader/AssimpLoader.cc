@@ -1,36 +1,46 @@
+#include <algorithm>
 #include <iostream>
 #include "AssimpLoader.h"
-#include "../Geometry/Geometry.h"
-#include "../Light/PointLight.h"
+#include "../Engine/Memory.h"
 
 namespace rt {
-    AssimpLoader::AssimpLoader(): _camera() {
+    AssimpLoader::AssimpLoader() {
         _scene = nullptr;
-        _importer = std::make_shared<Assimp::Importer>();
+    }
+
+    void AssimpLoader::SetLodOptions(LodOptions const& options) {
+        _lodOptions = options;
     }
 
     bool AssimpLoader::LoadFile(std::string const& filePath) {
-        _scene = _importer->ReadFile(filePath, aiProcess_Triangulate
-                                               | aiProcess_GenSmoothNormals
-                                               | aiProcess_FixInfacingNormals);
-        if (!_scene) {
-            std::cerr << "Error while importing scene: " << _importer->GetErrorString() << std::endl;
-            return false;
+        _result = Scene();
+        {
+            Assimp::Importer importer;
+            _scene = importer.ReadFile(filePath, aiProcess_Triangulate
+                                                 | aiProcess_GenSmoothNormals
+                                                 | aiProcess_FixInfacingNormals);
+            if (!_scene) {
+                std::cerr << "Error while importing scene: " << importer.GetErrorString() << std::endl;
+                return false;
+            }
+            _loadNode(_scene->mRootNode, aiMatrix4x4());
+            importer.FreeScene();
+            _scene = nullptr;
         }
-        _loadNode(_scene->mRootNode, aiMatrix4x4());   
+        _result.GenerateLods(_lodOptions);
+        _result.Shrink();
+        ReleaseFreeMemory();
         return true;
     }
 
-    Camera AssimpLoader::GetCameraFromScene() const {
-        return _camera;
-    }
-
-    std::vector<std::shared_ptr<Object>> const& AssimpLoader::GetMeshesFromScene() const {
-        return _meshes;
+    Scene const& AssimpLoader::GetScene() const {
+        return _result;
     }
 
-    std::vector<std::shared_ptr<PointLight>> const& AssimpLoader::GetLightsFromScene() const {
-        return _lights;
+    Scene AssimpLoader::TakeScene() {
+        Scene scene = std::move(_result);
+        _result = Scene();
+        return scene;
     }
 
     Vector3<float> AssimpLoader::_transform(aiMatrix4x4 const& mat, Vector3<float> const& point) const {
@@ -56,21 +66,29 @@ namespace rt {
         aiMatrix4x4 matrix = parent * node->mTransformation;
 
         if (_scene->mNumCameras > 0 && node->mName == _scene->mCameras[0]->mName) {
-            _camera.SetMatrix(
+            Camera camera;
+            camera.SetMatrix(
                 Vector3<float>(matrix.a1, -matrix.c1, matrix.b1),
                 Vector3<float>(matrix.a2, -matrix.c2, matrix.b2),
                 Vector3<float>(matrix.a3, -matrix.c3, matrix.b3),
                 Vector3<float>(matrix.a4, -matrix.c4, matrix.b4)
             );
+            _result.SetCamera(camera);
         }
         
         for (std::uint32_t lightIdx = 0; lightIdx < _scene->mNumLights; ++lightIdx) {
             aiLight* light = _scene->mLights[lightIdx];
             if (light->mName == node->mName) {
                 if (light->mType == aiLightSource_POINT) {
-                    _lights.emplace_back(new PointLight(
+                    // Exporters fold the light's energy into its colour, split it back into a hue and an intensity
+                    aiColor3D const& diffuse = light->mColorDiffuse;
+                    float const intensity = std::max({diffuse.r, diffuse.g, diffuse.b});
+                    float const scale = intensity > 0.f ? 1.f / intensity : 0.f;
+                    _result.AddLight(PointLight(
                          _transform(matrix, Vector3<float>(light->mPosition.x, light->mPosition.y, light->mPosition.z)),
-                        Color(light->mColorDiffuse.r, light->mColorDiffuse.g, light->mColorDiffuse.b)
+                        Color(Vector3<float>(diffuse.r * scale, diffuse.g * scale, diffuse.b * scale)),
+                        intensity,
+                        Attenuation{light->mAttenuationConstant, light->mAttenuationLinear, light->mAttenuationQuadratic}
                     ));
                 }
             }
@@ -79,7 +97,7 @@ namespace rt {
         for (std::uint32_t meshIdx = 0u; meshIdx < node->mNumMeshes; ++meshIdx) {
             aiMesh* mesh = _scene->mMeshes[node->mMeshes[meshIdx]];
             if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) || mesh->mNumVertices <= 0) continue;
-            std::vector<Triangle> triangles;
+            _result.AddObject(_loadMaterialFromMesh(mesh->mMaterialIndex));
             for (std::uint32_t faceIdx = 0u; faceIdx < mesh->mNumFaces; ++faceIdx) {
                 if (mesh->mFaces[faceIdx].mNumIndices == 3) {
                     unsigned int v1Idx = mesh->mFaces[faceIdx].mIndices[0];
@@ -117,10 +135,9 @@ namespace rt {
                             mesh->mNormals[v3Idx].z
                         )));
                     }
-                    triangles.emplace_back(v1, v2, v3);
+                    _result.AddTriangle(v1, v2, v3);
                 }
             }
-            _meshes.emplace_back(new Object(triangles, _loadMaterialFromMesh(mesh->mMaterialIndex)));
             std::cout << "Import done" << std::endl;
         }
 
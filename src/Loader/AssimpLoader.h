@@ -3,32 +3,28 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
-#include <vector>
-#include <memory>
-#include "../Geometry/Geometry.h"
-#include "../Camera/Camera.h"
-#include "../Light/PointLight.h"
+#include "../Scene/Scene.h"
 
 namespace rt
 {
+	// Converts a file into a flat Scene. The Assimp importer and its aiScene only live
+	// during LoadFile, so nothing of them stays in memory once the scene is built.
 	class AssimpLoader
 	{
 	public:
 		AssimpLoader();
 
-		AssimpLoader(const AssimpLoader &) = default;
-
+		// Objects the options select get their simplified levels generated as they load
+		void SetLodOptions(LodOptions const &options);
 		bool LoadFile(std::string const &filePath);
-		Camera GetCameraFromScene() const;
-		std::vector<std::shared_ptr<Object>> const &GetMeshesFromScene() const;
-		std::vector<std::shared_ptr<PointLight>> const &GetLightsFromScene() const;
+		Scene const &GetScene() const;
+		// Moves the scene out, leaving the loader empty
+		Scene TakeScene();
 
 	private:
 		const aiScene *_scene;
-		std::shared_ptr<Assimp::Importer> _importer;
-		Camera _camera;
-		std::vector<std::shared_ptr<Object>> _meshes;
-		std::vector<std::shared_ptr<PointLight>> _lights;
+		Scene _result;
+		LodOptions _lodOptions;
 
 		Vector3<float> _transform(aiMatrix4x4 const &mat, Vector3<float> const &point) const;
 		Vector3<float> const _loadMaterialFromMesh(unsigned int matIdx) const;
@@ -0,0 +1,60 @@
+#include "Message.h"
+
+namespace rt {
+    Message& Message::WriteBytes(void const* data, std::size_t size) {
+        std::uint8_t const* bytes = static_cast<std::uint8_t const*>(data);
+        _payload.insert(_payload.end(), bytes, bytes + size);
+        return *this;
+    }
+
+    Message& Message::WriteString(std::string const& value) {
+        Write(static_cast<std::uint32_t>(value.size()));
+        return WriteBytes(value.data(), value.size());
+    }
+
+    bool Message::ReadBytes(void* data, std::size_t size) {
+        if (_readPos + size > _payload.size()) {
+            return false;
+        }
+        std::memcpy(data, _payload.data() + _readPos, size);
+        _readPos += size;
+        return true;
+    }
+
+    bool Message::ReadString(std::string& value) {
+        std::uint32_t size = 0;
+        if (!Read(size) || _readPos + size > _payload.size()) {
+            return false;
+        }
+        value.assign(reinterpret_cast<char const*>(_payload.data() + _readPos), size);
+        _readPos += size;
+        return true;
+    }
+
+    bool Message::Send(Socket& socket) const {
+        if (_payload.size() > MaxMessageSize) {
+            return false;
+        }
+        std::uint8_t header[5];
+        std::uint32_t size = static_cast<std::uint32_t>(_payload.size());
+        std::memcpy(header, &size, sizeof(size));
+        header[4] = _type;
+        return socket.SendAll(header, sizeof(header)) && socket.SendAll(_payload.data(), _payload.size());
+    }
+
+    bool Message::Receive(Socket& socket) {
+        std::uint8_t header[5];
+        if (!socket.ReceiveAll(header, sizeof(header))) {
+            return false;
+        }
+        std::uint32_t size = 0;
+        std::memcpy(&size, header, sizeof(size));
+        _type = header[4];
+        if (size > MaxMessageSize) {
+            return false;
+        }
+        _payload.resize(size);
+        _readPos = 0;
+        return socket.ReceiveAll(_payload.data(), size);
+    }
+}  // namespace rt
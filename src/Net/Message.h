@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Socket.h"
+
+namespace rt {
+    // Length-prefixed message with a type tag. Values are copied in host byte order,
+    // both ends are expected to run on the same architecture.
+    class Message {
+    public:
+        explicit    Message(std::uint8_t type = 0) : _type(type), _readPos(0) {};
+
+        std::uint8_t    GetType() const {
+            return _type;
+        }
+
+        template <class T>
+        Message&    Write(T const& value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Message::Write needs a trivially copyable type");
+            return WriteBytes(&value, sizeof(T));
+        }
+
+        template <class T>
+        bool        Read(T& value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Message::Read needs a trivially copyable type");
+            return ReadBytes(&value, sizeof(T));
+        }
+
+        Message&    WriteBytes(void const* data, std::size_t size);
+        Message&    WriteString(std::string const& value);
+        bool        ReadBytes(void* data, std::size_t size);
+        bool        ReadString(std::string& value);
+
+        // Both fail for payloads above MaxMessageSize, so a peer cannot make the receiver allocate at will
+        bool        Send(Socket& socket) const;
+        bool        Receive(Socket& socket);
+
+        // Largest image either protocol sends back, and room for its RGBA pixels and the fields around them
+        static constexpr std::size_t    MaxImagePixels = std::size_t(8192) * 8192;
+        static constexpr std::size_t    MaxMessageSize = MaxImagePixels * 4 + 1024;
+
+    private:
+        std::uint8_t                _type;
+        std::vector<std::uint8_t>   _payload;
+        std::size_t                 _readPos;
+    };
+}  // namespace rt
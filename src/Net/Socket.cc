@@ -0,0 +1,179 @@
+#include "Socket.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace rt {
+    namespace {
+        std::intptr_t const InvalidHandle = -1;
+
+        #ifdef _WIN32
+        struct WinsockInit {
+            WinsockInit() {
+                WSADATA data;
+                WSAStartup(MAKEWORD(2, 2), &data);
+            }
+            ~WinsockInit() {
+                WSACleanup();
+            }
+        };
+        WinsockInit winsockInit;
+
+        void closeHandle(std::intptr_t handle) {
+            closesocket(static_cast<SOCKET>(handle));
+        }
+        #else
+        void closeHandle(std::intptr_t handle) {
+            ::close(static_cast<int>(handle));
+        }
+        #endif
+
+        void setNoDelay(std::intptr_t handle) {
+            int flag = 1;
+            setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char const*>(&flag), sizeof(flag));
+        }
+    }
+
+    Socket::Socket() : _handle(InvalidHandle) {
+    }
+
+    Socket::Socket(std::intptr_t handle) : _handle(handle) {
+    }
+
+    Socket::~Socket() {
+        Close();
+    }
+
+    Socket::Socket(Socket&& other) : _handle(other._handle) {
+        other._handle = InvalidHandle;
+    }
+
+    Socket& Socket::operator=(Socket&& other) {
+        if (this != &other) {
+            Close();
+            _handle = other._handle;
+            other._handle = InvalidHandle;
+        }
+        return *this;
+    }
+
+    bool Socket::Connect(std::string const& host, std::uint16_t port) {
+        Close();
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
+            return false;
+        }
+        for (addrinfo* address = result; address != nullptr; address = address->ai_next) {
+            std::intptr_t handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (handle == InvalidHandle) {
+                continue;
+            }
+            if (connect(handle, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0) {
+                _handle = handle;
+                break;
+            }
+            closeHandle(handle);
+        }
+        freeaddrinfo(result);
+        if (IsValid()) {
+            setNoDelay(_handle);
+        }
+        return IsValid();
+    }
+
+    bool Socket::Listen(std::uint16_t port, bool loopbackOnly) {
+        Close();
+        _handle = socket(AF_INET, SOCK_STREAM, 0);
+        if (!IsValid()) {
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(_handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&reuse), sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+        address.sin_port = htons(port);
+        if (bind(_handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(_handle, 16) != 0) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    Socket Socket::Accept() {
+        std::intptr_t handle = accept(_handle, nullptr, nullptr);
+        if (handle != InvalidHandle) {
+            setNoDelay(handle);
+        }
+        return Socket(handle);
+    }
+
+    bool Socket::WaitReadable(int timeoutMs) {
+        #ifdef _WIN32
+        WSAPOLLFD descriptor = {static_cast<SOCKET>(_handle), POLLRDNORM, 0};
+        return WSAPoll(&descriptor, 1, timeoutMs) > 0;
+        #else
+        pollfd descriptor = {static_cast<int>(_handle), POLLIN, 0};
+        return poll(&descriptor, 1, timeoutMs) > 0;
+        #endif
+    }
+
+    void Socket::Close() {
+        if (IsValid()) {
+            closeHandle(_handle);
+            _handle = InvalidHandle;
+        }
+    }
+
+    bool Socket::IsValid() const {
+        return _handle != InvalidHandle;
+    }
+
+    bool Socket::SendAll(void const* data, std::size_t size) {
+        char const* bytes = static_cast<char const*>(data);
+        while (size > 0) {
+            #ifdef _WIN32
+            int sent = send(_handle, bytes, static_cast<int>(size), 0);
+            #else
+            ssize_t sent = send(_handle, bytes, size, MSG_NOSIGNAL);
+            #endif
+            if (sent <= 0) {
+                return false;
+            }
+            bytes += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    bool Socket::ReceiveAll(void* data, std::size_t size) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            #ifdef _WIN32
+            int received = recv(_handle, bytes, static_cast<int>(size), 0);
+            #else
+            ssize_t received = recv(_handle, bytes, size, 0);
+            #endif
+            if (received <= 0) {
+                return false;
+            }
+            bytes += received;
+            size -= static_cast<std::size_t>(received);
+        }
+        return true;
+    }
+}  // namespace rt
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rt {
+    // Minimal blocking TCP socket over BSD sockets / Winsock.
+    class Socket {
+    public:
+        Socket();
+        ~Socket();
+
+        Socket(Socket&& other);
+        Socket& operator=(Socket&& other);
+        Socket(Socket const&) = delete;
+        Socket& operator=(Socket const&) = delete;
+
+        bool    Connect(std::string const& host, std::uint16_t port);
+        bool    Listen(std::uint16_t port, bool loopbackOnly = false);
+        Socket  Accept();
+        bool    WaitReadable(int timeoutMs);
+        void    Close();
+
+        bool    IsValid() const;
+        bool    SendAll(void const* data, std::size_t size);
+        bool    ReceiveAll(void* data, std::size_t size);
+
+    private:
+        std::intptr_t   _handle;
+
+        explicit    Socket(std::intptr_t handle);
+    };
+}  // namespace rt
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include "AnimationRenderer.h"
+
+namespace rt {
+    AnimationRenderer::AnimationRenderer(Engine const& engine, ThreadPool& pool, Camera const& camera, unsigned int spp)
+        : _camera(camera), _renderer(engine, pool), _spp(std::max(spp, 1u)) {
+    }
+
+    AnimationStats AnimationRenderer::Render(CameraPath const& path, Sink const& sink) {
+        Vector2<unsigned int> const res = _camera.GetRes();
+        std::array<Image, 2> buffers{Image(res), Image(res)};
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t traced = 0;
+        std::size_t encoded = 0;
+        bool failed = false;
+        AnimationStats stats;
+        std::size_t const frameCount = path.GetFrameCount();
+
+        auto const start = std::chrono::steady_clock::now();
+        std::thread encoder([&]() {
+            for (std::size_t frame = 0; frame < frameCount; ++frame) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return traced > frame || failed; });
+                    if (traced <= frame) {
+                        return;
+                    }
+                }
+                auto const encodeStart = std::chrono::steady_clock::now();
+                bool const written = sink(frame, buffers[frame % 2]);
+                float const encodeTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - encodeStart).count();
+                std::lock_guard<std::mutex> lock(mutex);
+                stats.EncodeTime += encodeTime;
+                failed = failed || !written;
+                encoded += written ? 1 : 0;
+                changed.notify_all();
+                if (failed) {
+                    return;
+                }
+            }
+        });
+
+        Camera camera = _camera;
+        for (std::size_t frame = 0; frame < frameCount; ++frame) {
+            {
+                // The buffer is free once the frame two back has been encoded
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return encoded + 2 > frame || failed; });
+                if (failed) {
+                    break;
+                }
+            }
+            auto const traceStart = std::chrono::steady_clock::now();
+            camera.SetPose(path.GetPose(frame));
+            Image& image = buffers[frame % 2];
+            _renderer.Render(camera, Tile(0, 0, res.X, res.Y), _spp, image.Pixels.data(), image.GetStride());
+            float const traceTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - traceStart).count();
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.TraceTime += traceTime;
+            ++traced;
+            changed.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = failed || traced < frameCount;
+        }
+        changed.notify_all();
+        encoder.join();
+        stats.WallTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.Frames = encoded;
+        return stats;
+    }
+
+    void AnimationRenderer::Report(AnimationStats const& stats, std::ostream& out) {
+        if (stats.Frames == 0) {
+            return;
+        }
+        // Without the overlap the wall time would be close to trace + encode
+        float const serial = stats.TraceTime + stats.EncodeTime;
+        out << std::fixed << std::setprecision(2)
+            << "frames: " << stats.Frames << " in " << stats.WallTime << " ms, fps: " << 1000.f * stats.Frames / stats.WallTime
+            << ", trace ms/frame: " << stats.TraceTime / stats.Frames << ", encode ms/frame: " << stats.EncodeTime / stats.Frames
+            << ", pipelining saved " << std::max(serial - stats.WallTime, 0.f) << " ms" << std::endl;
+    }
+}  // namespace rt
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include "../Camera/Camera.h"
+#include "../Camera/CameraPath.h"
+#include "../Engine/Engine.h"
+#include "Image.h"
+#include "ThreadPool.h"
+#include "TileRenderer.h"
+
+namespace rt {
+    struct AnimationStats {
+        std::size_t     Frames = 0;
+        float           WallTime = 0.f;
+        float           TraceTime = 0.f;
+        float           EncodeTime = 0.f;
+    };
+
+    // Renders a camera path frame by frame. Frames are double buffered: while the pool
+    // traces frame N+1, a separate thread hands frame N to the sink for encoding.
+    class AnimationRenderer {
+    public:
+        using Sink = std::function<bool(std::size_t, Image const&)>;
+
+        AnimationRenderer(Engine const& engine, ThreadPool& pool, Camera const& camera, unsigned int spp);
+
+        AnimationStats  Render(CameraPath const& path, Sink const& sink);
+        void            SetRasterization(bool enabled) { _renderer.SetRasterization(enabled); }
+
+        static void     Report(AnimationStats const& stats, std::ostream& out);
+
+    private:
+        Camera          _camera;
+        TileRenderer    _renderer;
+        unsigned int    _spp;
+    };
+}  // namespace rt
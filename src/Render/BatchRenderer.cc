@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "BatchRenderer.h"
+
+namespace rt {
+    BatchRenderer::BatchRenderer(Engine const& engine, ThreadPool& pool, Camera const& camera, unsigned int spp)
+        : _engine(engine), _camera(camera), _pool(pool), _renderer(engine, pool), _spp(std::max(spp, 1u)) {
+    }
+
+    BatchStats BatchRenderer::Render(std::vector<CameraPose> const& poses, Sink const& sink) {
+        struct View {
+            Camera                      Cam;
+            Image                       Picture;
+            std::atomic<std::size_t>    Remaining;
+            std::unique_ptr<Rasterizer> Visibility;
+        };
+
+        Vector2<unsigned int> const res = _camera.GetRes();
+        std::vector<Tile> tiles;
+        for (unsigned int y = 0; y < res.Y; y += TileSize) {
+            for (unsigned int x = 0; x < res.X; x += TileSize) {
+                tiles.emplace_back(x, y, std::min(TileSize, res.X - x), std::min(TileSize, res.Y - y));
+            }
+        }
+
+        BatchStats stats;
+        stats.Views = poses.size();
+        std::vector<std::unique_ptr<View>> views(poses.size());
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::size_t> finished;
+        std::size_t inFlight = 0;
+        bool submitted = false;
+        bool sinkFailed = false;
+
+        auto const start = std::chrono::steady_clock::now();
+        std::thread writer([&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                changed.wait(lock, [&]() { return !finished.empty() || submitted; });
+                if (finished.empty()) {
+                    return;
+                }
+                std::size_t const index = finished.front();
+                finished.pop_front();
+                lock.unlock();
+                auto const writeStart = std::chrono::steady_clock::now();
+                bool const written = sink(index, views[index]->Picture);
+                float const writeTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - writeStart).count();
+                views[index].reset();
+                lock.lock();
+                stats.WriteTime += writeTime;
+                stats.Written += written ? 1 : 0;
+                sinkFailed = sinkFailed || !written;
+                --inFlight;
+                changed.notify_all();
+            }
+        });
+
+        {
+            TaskGroup group(_pool);
+            for (std::size_t index = 0; index < poses.size(); ++index) {
+                {
+                    // Bounds the number of images alive at once
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return inFlight < ViewsInFlight || sinkFailed; });
+                    if (sinkFailed) {
+                        break;
+                    }
+                    ++inFlight;
+                }
+                auto view = std::make_unique<View>();
+                view->Cam = _camera;
+                view->Cam.SetPose(poses[index]);
+                view->Picture = Image(res);
+                view->Remaining = tiles.size();
+                if (_rasterize) {
+                    view->Visibility = std::make_unique<Rasterizer>(_engine);
+                    view->Visibility->Setup(view->Cam);
+                }
+                View* current = view.get();
+                views[index] = std::move(view);
+                for (Tile const& tile : tiles) {
+                    group.Run([&, current, index, tile]() {
+                        Image& picture = current->Picture;
+                        _renderer.RenderBlock(current->Cam, tile, _spp, &picture.Pixels[tile.Y * picture.GetStride() + tile.X * 4],
+                                              picture.GetStride(), current->Visibility.get());
+                        if (current->Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            finished.push_back(index);
+                            changed.notify_all();
+                        }
+                    });
+                }
+            }
+            group.Wait();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            submitted = true;
+        }
+        changed.notify_all();
+        writer.join();
+        stats.WallTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.Rays = static_cast<double>(res.X) * res.Y * _spp * stats.Written;
+        return stats;
+    }
+
+    void BatchRenderer::Report(BatchStats const& stats, std::ostream& out) {
+        float const seconds = stats.WallTime / 1000.f;
+        out << std::fixed << std::setprecision(2)
+            << "views: " << stats.Written << " / " << stats.Views << " in " << stats.WallTime << " ms"
+            << ", views/s: " << (seconds > 0.f ? stats.Written / seconds : 0.f)
+            << ", primary rays/s: " << (seconds > 0.f ? stats.Rays / seconds : 0.0)
+            << ", writing: " << stats.WriteTime << " ms" << std::endl;
+    }
+}  // namespace rt
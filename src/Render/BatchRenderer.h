@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <vector>
+#include "../Camera/Camera.h"
+#include "../Engine/Engine.h"
+#include "Image.h"
+#include "ThreadPool.h"
+#include "TileRenderer.h"
+
+namespace rt {
+    struct BatchStats {
+        std::size_t     Views = 0;
+        std::size_t     Written = 0;
+        float           WallTime = 0.f;
+        float           WriteTime = 0.f;
+        double          Rays = 0.0;
+    };
+
+    // Renders many views of one scene. The tiles of consecutive views share one task
+    // queue, so threads move on to the next view instead of idling at the end of each
+    // image, and finished images go to the sink on a separate thread as they complete.
+    class BatchRenderer {
+    public:
+        using Sink = std::function<bool(std::size_t, Image const&)>;
+
+        BatchRenderer(Engine const& engine, ThreadPool& pool, Camera const& camera, unsigned int spp);
+
+        BatchStats  Render(std::vector<CameraPose> const& poses, Sink const& sink);
+        void        SetReplicas(EngineReplicas const* replicas) { _renderer.SetReplicas(replicas); }
+        // Rasterizes each view on the submitting thread while the pool traces the previous ones
+        void        SetRasterization(bool enabled) { _rasterize = enabled; }
+
+        static void Report(BatchStats const& stats, std::ostream& out);
+
+        static constexpr unsigned int   TileSize = 32;
+        static constexpr std::size_t    ViewsInFlight = 4;
+
+    private:
+        Engine const&   _engine;
+        Camera          _camera;
+        ThreadPool&     _pool;
+        TileRenderer    _renderer;
+        unsigned int    _spp;
+        bool            _rasterize = false;
+    };
+}  // namespace rt
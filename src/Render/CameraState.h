@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include "../Camera/Camera.h"
+#include "TripleBuffer.h"
+
+namespace rt {
+    struct VersionedPose {
+        CameraPose      Pose;
+        std::uint64_t   Version = 0;
+    };
+
+    // Hands camera poses from the UI thread to the renderer without locking.
+    // Every Store() bumps the version, so frames can be tagged with the pose they were traced with.
+    class CameraState {
+    public:
+        CameraState() : _version(0) {};
+
+        void    Store(CameraPose const& pose) {
+            VersionedPose& back = _poses.Back();
+            back.Pose = pose;
+            back.Version = ++_version;
+            _poses.Publish();
+        }
+
+        bool    Load(VersionedPose& pose) {
+            if (!_poses.Update()) {
+                return false;
+            }
+            pose = _poses.Front();
+            return true;
+        }
+
+    private:
+        TripleBuffer<VersionedPose>     _poses;
+        std::uint64_t                   _version;
+    };
+}  // namespace rt
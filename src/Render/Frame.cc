@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cstring>
+#include "Frame.h"
+
+namespace rt {
+    void Frame::Resize(Vector2<unsigned int> const& res) {
+        Res = res;
+        Tiles = Vector2<unsigned int>((res.X + TileSize - 1) / TileSize, (res.Y + TileSize - 1) / TileSize);
+        Pixels.resize(static_cast<std::size_t>(res.X) * res.Y * 4);
+        TileStamps.assign(static_cast<std::size_t>(Tiles.X) * Tiles.Y, 0);
+        Index = 0;
+        Clear();
+    }
+
+    void Frame::Clear() {
+        for (std::size_t i = 0; i < Pixels.size(); i += 4) {
+            Pixels[i] = 0;
+            Pixels[i + 1] = 0;
+            Pixels[i + 2] = 0;
+            Pixels[i + 3] = 255;
+        }
+    }
+
+    void Frame::SetPixel(std::size_t pixel, Color const& color) {
+        Color_Component const components = color.GetColor();
+        std::uint8_t* dst = &Pixels[pixel * 4];
+        dst[0] = components.rgba.r;
+        dst[1] = components.rgba.g;
+        dst[2] = components.rgba.b;
+        dst[3] = 255;
+    }
+
+    void Frame::CopyTile(Frame const& other, std::size_t tile) {
+        Tile const rect = GetTile(tile);
+        std::size_t const stride = static_cast<std::size_t>(Res.X) * 4;
+        std::size_t offset = rect.Y * stride + rect.X * 4;
+        for (unsigned int row = 0; row < rect.Height; ++row, offset += stride) {
+            std::memcpy(&Pixels[offset], &other.Pixels[offset], rect.Width * 4);
+        }
+    }
+
+    std::size_t Frame::TileOf(std::size_t pixel) const {
+        std::size_t x = pixel % Res.X;
+        std::size_t y = pixel / Res.X;
+        return (y / TileSize) * Tiles.X + x / TileSize;
+    }
+
+    Tile Frame::GetTile(std::size_t tile) const {
+        unsigned int x = static_cast<unsigned int>(tile % Tiles.X) * TileSize;
+        unsigned int y = static_cast<unsigned int>(tile / Tiles.X) * TileSize;
+        return Tile(x, y, std::min(TileSize, Res.X - x), std::min(TileSize, Res.Y - y));
+    }
+
+    void Frame::DirtyRegions(std::uint64_t since, std::vector<Tile>& regions) const {
+        regions.clear();
+        for (unsigned int ty = 0; ty < Tiles.Y; ++ty) {
+            unsigned int tx = 0;
+            while (tx < Tiles.X) {
+                if (TileStamps[ty * Tiles.X + tx] <= since) {
+                    ++tx;
+                    continue;
+                }
+                unsigned int first = tx;
+                while (tx < Tiles.X && TileStamps[ty * Tiles.X + tx] > since) {
+                    ++tx;
+                }
+                Tile const start = GetTile(ty * Tiles.X + first);
+                Tile const end = GetTile(ty * Tiles.X + tx - 1);
+                Tile span(start.X, start.Y, end.X + end.Width - start.X, start.Height);
+                // Full-width spans of consecutive tile rows are contiguous in memory, merge them
+                if (!regions.empty() && span.Width == Res.X && regions.back().Width == Res.X
+                    && regions.back().Y + regions.back().Height == span.Y) {
+                    regions.back().Height += span.Height;
+                } else {
+                    regions.push_back(span);
+                }
+            }
+        }
+    }
+}  // namespace rt
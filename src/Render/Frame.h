@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../Engine/Color.h"
+#include "../Engine/Tools.h"
+#include "../Vector/Vector2.h"
+
+namespace rt {
+    // Packed RGBA8 image, laid out exactly as sf::Texture::update expects it.
+    // TileStamps holds, per tile, the Index of the last frame that changed it.
+    struct Frame {
+        static constexpr unsigned int TileSize = 32;
+
+        Vector2<unsigned int>       Res;
+        Vector2<unsigned int>       Tiles;
+        std::vector<std::uint8_t>   Pixels;
+        std::vector<std::uint64_t>  TileStamps;
+        std::uint64_t               CameraVersion = 0;
+        std::uint64_t               Index = 0;
+
+        void        Resize(Vector2<unsigned int> const& res);
+        void        Clear();
+        void        SetPixel(std::size_t pixel, Color const& color);
+        void        CopyTile(Frame const& other, std::size_t tile);
+        std::size_t TileOf(std::size_t pixel) const;
+        Tile        GetTile(std::size_t tile) const;
+        void        DirtyRegions(std::uint64_t since, std::vector<Tile>& regions) const;
+    };
+}  // namespace rt
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include "FrameBudget.h"
+
+namespace rt {
+    namespace {
+        // Weight of the newest measurement in the exponential moving averages
+        constexpr float Smoothing = 0.2f;
+    }
+
+    FrameBudget::FrameBudget(float targetFps) : _targetFps(targetFps), _sampleLimit(~std::size_t(0)),
+        _sampleCount(InitialSamples), _raysPerSecond(0.f), _overhead(0.f), _frames(0), _history() {
+    }
+
+    void FrameBudget::SetTargetFps(float fps) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _targetFps = fps;
+    }
+
+    void FrameBudget::SetSampleLimit(std::size_t limit) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sampleLimit = std::max(limit, MinSamples);
+        _sampleCount = std::min(_sampleCount, _sampleLimit);
+    }
+
+    std::size_t FrameBudget::GetSampleCount() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _sampleCount;
+    }
+
+    void FrameBudget::Record(std::size_t rays, float traceTime, float frameTime) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _history[_frames % HistorySize] = frameTime;
+        ++_frames;
+        if (rays == 0 || traceTime <= 0.f) {
+            return;
+        }
+        float raysPerSecond = rays * 1000.f / traceTime;
+        float overhead = std::max(frameTime - traceTime, 0.f);
+        if (_raysPerSecond == 0.f) {
+            _raysPerSecond = raysPerSecond;
+            _overhead = overhead;
+        } else {
+            _raysPerSecond += Smoothing * (raysPerSecond - _raysPerSecond);
+            _overhead += Smoothing * (overhead - _overhead);
+        }
+        float budget = std::max(1000.f / _targetFps - _overhead, 0.f);
+        std::size_t samples = static_cast<std::size_t>(_raysPerSecond * budget / 1000.f);
+        _sampleCount = std::min(std::max(samples, MinSamples), _sampleLimit);
+    }
+
+    FrameStats FrameBudget::GetStats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        FrameStats stats;
+        stats.Frames = _frames;
+        stats.SampleCount = _sampleCount;
+        stats.RaysPerSecond = _raysPerSecond;
+        std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(_frames, HistorySize));
+        if (count == 0) {
+            return stats;
+        }
+        std::vector<float> times(_history.begin(), _history.begin() + count);
+        std::sort(times.begin(), times.end());
+        float total = 0.f;
+        for (float time : times) {
+            total += time;
+        }
+        stats.MeanFrameTime = total / count;
+        stats.MinFrameTime = times.front();
+        stats.MaxFrameTime = times.back();
+        stats.P95FrameTime = times[std::min(count - 1, count * 95 / 100)];
+        return stats;
+    }
+
+    void FrameBudget::Report(std::ostream& out) const {
+        FrameStats stats = GetStats();
+        out << std::fixed << std::setprecision(2)
+            << "frames: " << stats.Frames << ", samples/frame: " << stats.SampleCount
+            << ", rays/s: " << stats.RaysPerSecond
+            << ", frame ms mean/min/p95/max: " << stats.MeanFrameTime << " / " << stats.MinFrameTime
+            << " / " << stats.P95FrameTime << " / " << stats.MaxFrameTime << std::endl;
+    }
+}  // namespace rt
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+namespace rt {
+    struct FrameStats {
+        std::uint64_t   Frames = 0;
+        std::size_t     SampleCount = 0;
+        float           RaysPerSecond = 0.f;
+        float           MeanFrameTime = 0.f;
+        float           MinFrameTime = 0.f;
+        float           MaxFrameTime = 0.f;
+        float           P95FrameTime = 0.f;
+    };
+
+    // Measures the tracing throughput online and sizes the next sample batch so
+    // that trace plus per-frame overhead fits into the frame time of the target FPS.
+    class FrameBudget {
+    public:
+        explicit    FrameBudget(float targetFps = DefaultFps);
+
+        void        SetTargetFps(float fps);
+        void        SetSampleLimit(std::size_t limit);
+        std::size_t GetSampleCount() const;
+        void        Record(std::size_t rays, float traceTime, float frameTime);
+        FrameStats  GetStats() const;
+        void        Report(std::ostream& out) const;
+
+        static constexpr float          DefaultFps = 30.f;
+        static constexpr std::size_t    InitialSamples = 10'000;
+        static constexpr std::size_t    MinSamples = 1'000;
+        static constexpr std::size_t    HistorySize = 128;
+
+    private:
+        mutable std::mutex                  _mutex;
+        float                               _targetFps;
+        std::size_t                         _sampleLimit;
+        std::size_t                         _sampleCount;
+        float                               _raysPerSecond;
+        float                               _overhead;
+        std::uint64_t                       _frames;
+        std::array<float, HistorySize>      _history;
+    };
+}  // namespace rt
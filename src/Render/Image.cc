@@ -0,0 +1,93 @@
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include "Image.h"
+
+namespace rt {
+    Image::Image(Vector2<unsigned int> const& res) : Res(res), Pixels(static_cast<std::size_t>(res.X) * res.Y * 4, 255) {
+    }
+
+    std::size_t Image::GetStride() const {
+        return static_cast<std::size_t>(Res.X) * 4;
+    }
+
+    void Image::SetTile(Tile const& tile, std::uint8_t const* rgba) {
+        std::size_t const rowSize = static_cast<std::size_t>(tile.Width) * 4;
+        for (unsigned int row = 0; row < tile.Height; ++row) {
+            std::memcpy(&Pixels[(tile.Y + row) * GetStride() + tile.X * 4], rgba + row * rowSize, rowSize);
+        }
+    }
+
+    bool Image::WritePPM(std::string const& path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "Cannot write image " << path << std::endl;
+            return false;
+        }
+        out << "P6\n" << Res.X << " " << Res.Y << "\n255\n";
+        std::vector<char> row(static_cast<std::size_t>(Res.X) * 3);
+        for (unsigned int y = 0; y < Res.Y; ++y) {
+            std::uint8_t const* src = &Pixels[y * GetStride()];
+            for (unsigned int x = 0; x < Res.X; ++x) {
+                row[x * 3] = static_cast<char>(src[x * 4]);
+                row[x * 3 + 1] = static_cast<char>(src[x * 4 + 1]);
+                row[x * 3 + 2] = static_cast<char>(src[x * 4 + 2]);
+            }
+            out.write(row.data(), row.size());
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool Image::ReadPPM(std::string const& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "Cannot read image " << path << std::endl;
+            return false;
+        }
+        // Header fields are separated by whitespace and may be followed by # comments
+        auto field = [&in](unsigned int& value) {
+            while (in >> std::ws && in.peek() == '#') {
+                in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+            return static_cast<bool>(in >> value);
+        };
+        std::string magic;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned int maxValue = 0;
+        if (!(in >> magic) || magic != "P6" || !field(width) || !field(height) || !field(maxValue) || maxValue != 255) {
+            std::cerr << "Unsupported image " << path << ", expected an 8-bit binary PPM" << std::endl;
+            return false;
+        }
+        in.get();
+        *this = Image(Vector2<unsigned int>(width, height));
+        std::vector<char> row(static_cast<std::size_t>(width) * 3);
+        for (unsigned int y = 0; y < height; ++y) {
+            if (!in.read(row.data(), row.size())) {
+                std::cerr << "Truncated image " << path << std::endl;
+                return false;
+            }
+            std::uint8_t* dst = &Pixels[y * GetStride()];
+            for (unsigned int x = 0; x < width; ++x) {
+                dst[x * 4] = static_cast<std::uint8_t>(row[x * 3]);
+                dst[x * 4 + 1] = static_cast<std::uint8_t>(row[x * 3 + 1]);
+                dst[x * 4 + 2] = static_cast<std::uint8_t>(row[x * 3 + 2]);
+            }
+        }
+        return true;
+    }
+
+    std::string NumberedPath(std::string const& path, std::size_t index) {
+        std::size_t const slash = path.find_last_of("/\\");
+        std::size_t dot = path.rfind('.');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+            dot = path.size();
+        }
+        std::ostringstream name;
+        name << path.substr(0, dot) << "_" << std::setw(5) << std::setfill('0') << index << path.substr(dot);
+        return name.str();
+    }
+}  // namespace rt
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Engine/Tools.h"
+#include "../Vector/Vector2.h"
+
+namespace rt {
+    // Packed RGBA8 image used by the headless render modes.
+    struct Image {
+        Image() {};
+        explicit Image(Vector2<unsigned int> const& res);
+
+        Vector2<unsigned int>       Res;
+        std::vector<std::uint8_t>   Pixels;
+
+        std::size_t     GetStride() const;
+        void            SetTile(Tile const& tile, std::uint8_t const* rgba);
+        bool            WritePPM(std::string const& path) const;
+        // Reads a binary PPM with 8-bit channels, as written by WritePPM
+        bool            ReadPPM(std::string const& path);
+    };
+
+    // "out/render.ppm", 7 -> "out/render_00007.ppm"
+    std::string NumberedPath(std::string const& path, std::size_t index);
+}  // namespace rt
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include "../Engine/Constant.h"
+#include "Rasterizer.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RT_RASTER_SSE
+#endif
+
+namespace rt {
+    namespace {
+        // Rays only meet points at least MinDist along them, which is Z, so nearer parts are clipped
+        constexpr float Near = Constant::MinDist / 2.f;
+        constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+        #ifdef RT_RASTER_SSE
+        __m128 select(__m128 mask, __m128 a, __m128 b) {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        __m128i select(__m128 mask, __m128i a, __m128i b) {
+            __m128i const bits = _mm_castps_si128(mask);
+            return _mm_or_si128(_mm_and_si128(bits, a), _mm_andnot_si128(bits, b));
+        }
+        #endif
+    }
+
+    Rasterizer::Rasterizer(Engine const& engine) : _engine(engine) {
+    }
+
+    void Rasterizer::Setup(Camera const& camera) {
+        _camera = camera;
+        _res = camera.GetRes();
+        Vector3<float> const& eye = camera.GetPos();
+        Vector3<float> const& pixelDX = camera.GetPixelDX();
+        Vector3<float> const& pixelDY = camera.GetPixelDY();
+        Vector3<float> const corner = camera.GetCornerDirection();
+        _eye = Vector3<double>(eye.X, eye.Y, eye.Z);
+        _pixelDX = Vector3<double>(pixelDX.X, pixelDX.Y, pixelDX.Z);
+        _pixelDY = Vector3<double>(pixelDY.X, pixelDY.Y, pixelDY.Z);
+        _corner = Vector3<double>(corner.X, corner.Y, corner.Z);
+        // The longest ray direction leaves a corner of the screen
+        _reach = 0.0;
+        for (double y : {0.0, static_cast<double>(_res.Y)}) {
+            for (double x : {0.0, static_cast<double>(_res.X)}) {
+                _reach = std::max(_reach, (_corner + _pixelDX * x + _pixelDY * y).Norm());
+            }
+        }
+        _binsX = (_res.X + BinSize - 1) / BinSize;
+        _binsY = (_res.Y + BinSize - 1) / BinSize;
+        _bins.resize(static_cast<std::size_t>(_binsX) * _binsY);
+        for (std::vector<std::uint32_t>& bin : _bins) {
+            bin.clear();
+        }
+        _settles = true;
+        _engine.GetCameraSlots(camera.GetPos(), _slots);
+        _primitives.clear();
+        _primitives.reserve(_slots.size());
+        for (std::uint32_t slot : _slots) {
+            _project(slot);
+        }
+    }
+
+    void Rasterizer::Resolve(Tile const& tile, unsigned int sampleIndex, std::vector<VisibilitySample>& samples,
+                             Buffer& buffer) const {
+        // Rows are written four pixels at a time, so the last one may spill past the tile
+        std::size_t const count = static_cast<std::size_t>(tile.Width) * tile.Height;
+        buffer.Inner.assign(count + 3, -Infinity);
+        buffer.InnerSlots.assign(count + 3, RayHit::NoHit);
+        buffer.Outer.assign(count + 3, -Infinity);
+        buffer.OuterSlots.assign(count + 3, RayHit::NoHit);
+        buffer.Second.assign(count + 3, -Infinity);
+        samples.assign(count, VisibilitySample());
+        if (count == 0 || _bins.empty()) {
+            return;
+        }
+        Vector2<float> const sample = _camera.GetSampleOffset(sampleIndex);
+        unsigned int const lastX = std::min((tile.X + tile.Width - 1) / BinSize, _binsX - 1);
+        unsigned int const lastY = std::min((tile.Y + tile.Height - 1) / BinSize, _binsY - 1);
+        for (unsigned int y = tile.Y / BinSize; y <= lastY; ++y) {
+            for (unsigned int x = tile.X / BinSize; x <= lastX; ++x) {
+                for (std::uint32_t index : _bins[static_cast<std::size_t>(y) * _binsX + x]) {
+                    _rasterize(_primitives[index], tile, sample, buffer);
+                }
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            VisibilitySample& out = samples[i];
+            if (buffer.OuterSlots[i] == RayHit::NoHit) {
+                out.Settled = _settles && buffer.Second[i] < Infinity;
+                continue;
+            }
+            out.Slot = buffer.InnerSlots[i] != RayHit::NoHit ? buffer.InnerSlots[i] : buffer.OuterSlots[i];
+            out.Settled = _settles && buffer.InnerSlots[i] == buffer.OuterSlots[i]
+                       && buffer.Second[i] < buffer.Outer[i] * (1.f - DepthMargin);
+        }
+    }
+
+    void Rasterizer::_project(std::uint32_t slot) {
+        Triangle const& triangle = _engine.GetTriangle(slot);
+        Vector3<float> const corners[3] = {triangle.GetV1().GetPos(), triangle.GetV2().GetPos(), triangle.GetV3().GetPos()};
+        Vector3<float> p[3];
+        int front = 0;
+        double nearest = std::numeric_limits<double>::max();
+        for (int k = 0; k < 3; ++k) {
+            p[k] = _camera.Project(corners[k]);
+            if (!std::isfinite(p[k].Z)) {
+                _settles = false;
+                return;
+            }
+            front += p[k].Z >= Near;
+            nearest = std::min(nearest, std::max(static_cast<double>(p[k].Z), static_cast<double>(Near)));
+        }
+        if (front == 0) {
+            return;
+        }
+        // Only the screen bounds come from projected corners, of the part clipped at Near. Z is
+        // affine in space, so the crossing points divide each edge by their Z.
+        double minX = std::numeric_limits<double>::max();
+        double maxX = -std::numeric_limits<double>::max();
+        double minY = std::numeric_limits<double>::max();
+        double maxY = -std::numeric_limits<double>::max();
+        for (int k = 0; k < 3; ++k) {
+            int const next = (k + 1) % 3;
+            Vector3<float> bounds[2];
+            int count = 0;
+            if (p[k].Z >= Near) {
+                bounds[count++] = p[k];
+            }
+            if ((p[k].Z < Near) != (p[next].Z < Near)) {
+                float const s = (Near - p[k].Z) / (p[next].Z - p[k].Z);
+                bounds[count++] = _camera.Project(corners[k] + (corners[next] - corners[k]) * s);
+            }
+            for (int i = 0; i < count; ++i) {
+                minX = std::min(minX, static_cast<double>(bounds[i].X));
+                maxX = std::max(maxX, static_cast<double>(bounds[i].X));
+                minY = std::min(minY, static_cast<double>(bounds[i].Y));
+                maxY = std::max(maxY, static_cast<double>(bounds[i].Y));
+            }
+        }
+        if (!std::isfinite(minX) || !std::isfinite(maxX) || !std::isfinite(minY) || !std::isfinite(maxY)) {
+            _settles = false;
+            return;
+        }
+        _add(slot, minX, maxX, minY, maxY, nearest);
+    }
+
+    void Rasterizer::_add(std::uint32_t slot, double minX, double maxX, double minY, double maxY, double nearest) {
+        // With d = a v0 + b v1 + c v2 the ray direction through a sample, the ray meets the triangle
+        // where a, b and c are not negative, at 1 / Z = a + b + c. Each is linear in the sample.
+        Triangle const& triangle = _engine.GetTriangle(slot);
+        Vector3<float> const corners[3] = {triangle.GetV1().GetPos(), triangle.GetV2().GetPos(), triangle.GetV3().GetPos()};
+        Vector3<double> v[3];
+        double scale = std::max({std::fabs(_eye.X), std::fabs(_eye.Y), std::fabs(_eye.Z)});
+        for (int k = 0; k < 3; ++k) {
+            v[k] = Vector3<double>(corners[k].X, corners[k].Y, corners[k].Z) - _eye;
+            scale = std::max({scale, std::fabs(static_cast<double>(corners[k].X)), std::fabs(static_cast<double>(corners[k].Y)),
+                              std::fabs(static_cast<double>(corners[k].Z))});
+        }
+        Vector3<double> const normal = (v[1] - v[0]).Cross(v[2] - v[0]);
+        double const volume = normal.Dot(v[0]);
+        Vector3<double> edges[3];
+        double length[3];
+        bool placed = volume != 0.0 && std::isfinite(volume);
+        double longest = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            edges[k] = v[(k + 1) % 3].Cross(v[(k + 2) % 3]) * (volume < 0.0 ? -1.0 : 1.0);
+            double const a = edges[k].Dot(_pixelDX);
+            double const b = edges[k].Dot(_pixelDY);
+            length[k] = std::sqrt(a * a + b * b);
+            placed = placed && length[k] > 0.0 && std::isfinite(length[k]);
+            longest = std::max(longest, (v[(k + 1) % 3] - v[k]).Norm());
+        }
+        // The ray test's determinant is the volume times the depth, 1 / Z, plus its rounding. Where
+        // that stays below Epsilon nothing can hit the triangle, as for the corners of a sphere's poles.
+        double const spread = 8.0 * FLT_EPSILON * _reach * longest * longest;
+        if (std::fabs(volume) / nearest + spread < Constant::Epsilon / 2.0) {
+            return;
+        }
+        // Triangle::Hit rounds its barycentrics by about the edges' products with the ray direction
+        // and the coordinates over its determinant, normal . d. Moved onto the screen that is the same
+        // number of pixels at every depth, so it widens the margin.
+        double const shortest = std::min({length[0], length[1], length[2]});
+        double const margin = placed ? Margin + 8.0 * FLT_EPSILON * _reach * longest * (longest + scale) / shortest : 0.0;
+
+        // Projected corners are only as exact as their magnitude allows
+        double const extent = std::max({std::fabs(minX), std::fabs(maxX), std::fabs(minY), std::fabs(maxY)});
+        double const slack = margin + 4.0 * FLT_EPSILON * extent;
+        if (maxX + slack < 0.0 || maxY + slack < 0.0 || minX - slack >= _res.X || minY - slack >= _res.Y) {
+            return;
+        }
+        Primitive primitive;
+        primitive.Slot = slot;
+        primitive.Margin = static_cast<float>(margin);
+        // A sample sits within one pixel of the pixel's corner
+        primitive.MinX = static_cast<unsigned int>(std::max(std::floor(minX - slack), 0.0));
+        primitive.MinY = static_cast<unsigned int>(std::max(std::floor(minY - slack), 0.0));
+        primitive.MaxX = static_cast<unsigned int>(std::min(std::floor(maxX + slack), _res.X - 1.0));
+        primitive.MaxY = static_cast<unsigned int>(std::min(std::floor(maxY + slack), _res.Y - 1.0));
+        if (!placed) {
+            // Seen edge on, but rounding may still let a ray through, so its samples go to the tracer
+            primitive.Slot = RayHit::NoHit;
+            for (int k = 0; k < 3; ++k) {
+                primitive.EdgeA[k] = 0.f;
+                primitive.EdgeB[k] = 0.f;
+                primitive.EdgeC[k] = 0.f;
+            }
+            _bin(primitive);
+            return;
+        }
+        Vector3<double> const origin = _corner + _pixelDX * static_cast<double>(primitive.MinX) + _pixelDY * static_cast<double>(primitive.MinY);
+        for (int k = 0; k < 3; ++k) {
+            primitive.EdgeA[k] = static_cast<float>(edges[k].Dot(_pixelDX) / length[k]);
+            primitive.EdgeB[k] = static_cast<float>(edges[k].Dot(_pixelDY) / length[k]);
+            primitive.EdgeC[k] = static_cast<float>(edges[k].Dot(origin) / length[k]);
+        }
+        double const depthA = normal.Dot(_pixelDX) / volume;
+        double const depthB = normal.Dot(_pixelDY) / volume;
+        double const depthC = normal.Dot(origin) / volume;
+        primitive.DepthA = static_cast<float>(depthA);
+        primitive.DepthB = static_cast<float>(depthB);
+        primitive.DepthC = static_cast<float>(depthC);
+        // The determinant must clear Epsilon by more than its rounding. The depth is evaluated in floats, whose error must stay well below DepthMargin.
+        // Hits nearer than MinDist are rejected, so depths around its inverse are ambiguous.
+        double const width = primitive.MaxX - primitive.MinX + 1.0;
+        double const height = primitive.MaxY - primitive.MinY + 1.0;
+        double const rounding = 4.0 * FLT_EPSILON * (std::fabs(depthA) * width + std::fabs(depthB) * height + std::fabs(depthC));
+        double const determinant = (2.0 * Constant::Epsilon + spread) / std::fabs(volume);
+        primitive.DepthLow = static_cast<float>(std::max(rounding * 8.0 / DepthMargin, determinant));
+        primitive.DepthHigh = 1.f / (2.f * Constant::MinDist);
+        _bin(primitive);
+    }
+
+    void Rasterizer::_bin(Primitive const& primitive) {
+        std::uint32_t const index = static_cast<std::uint32_t>(_primitives.size());
+        _primitives.push_back(primitive);
+        for (unsigned int y = primitive.MinY / BinSize; y <= primitive.MaxY / BinSize; ++y) {
+            for (unsigned int x = primitive.MinX / BinSize; x <= primitive.MaxX / BinSize; ++x) {
+                _bins[static_cast<std::size_t>(y) * _binsX + x].push_back(index);
+            }
+        }
+    }
+
+    void Rasterizer::_rasterize(Primitive const& primitive, Tile const& tile, Vector2<float> const& sample, Buffer& buffer) const {
+        unsigned int const x0 = std::max(primitive.MinX, tile.X);
+        unsigned int const y0 = std::max(primitive.MinY, tile.Y);
+        unsigned int const x1 = std::min(primitive.MaxX, tile.X + tile.Width - 1);
+        unsigned int const y1 = std::min(primitive.MaxY, tile.Y + tile.Height - 1);
+        if (x0 > x1 || y0 > y1) {
+            return;
+        }
+        float const* a = primitive.EdgeA;
+        float const margin = primitive.Margin;
+        bool const placed = primitive.Slot != RayHit::NoHit;
+        for (unsigned int y = y0; y <= y1; ++y) {
+            float const sy = static_cast<float>(y - primitive.MinY) + sample.Y;
+            float const row[3] = {primitive.EdgeB[0] * sy + primitive.EdgeC[0], primitive.EdgeB[1] * sy + primitive.EdgeC[1],
+                                  primitive.EdgeB[2] * sy + primitive.EdgeC[2]};
+            float const rowDepth = primitive.DepthB * sy + primitive.DepthC;
+            // Pointers to the tile's column 0 in this row, the loops index them from there
+            std::size_t const offset = static_cast<std::size_t>(y - tile.Y) * tile.Width;
+            float* inner = buffer.Inner.data() + offset;
+            std::uint32_t* innerSlots = buffer.InnerSlots.data() + offset;
+            float* outer = buffer.Outer.data() + offset;
+            std::uint32_t* outerSlots = buffer.OuterSlots.data() + offset;
+            float* second = buffer.Second.data() + offset;
+            unsigned int x = x0;
+            #ifdef RT_RASTER_SSE
+            __m128 const lanes = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+            __m128 const in = _mm_set1_ps(margin);
+            __m128 const out = _mm_set1_ps(-margin);
+            __m128 const infinity = _mm_set1_ps(Infinity);
+            __m128 const low = _mm_set1_ps(primitive.DepthLow);
+            __m128 const high = _mm_set1_ps(primitive.DepthHigh);
+            __m128i const slot = _mm_set1_epi32(static_cast<int>(primitive.Slot));
+            for (; x <= x1; x += 4) {
+                std::size_t const i = x - tile.X;
+                __m128 const sx = _mm_add_ps(_mm_set1_ps(static_cast<float>(x - primitive.MinX) + sample.X), lanes);
+                __m128 covered = _mm_cmplt_ps(lanes, _mm_set1_ps(static_cast<float>(x1 - x + 1)));
+                __m128 inside = covered;
+                for (int k = 0; k < 3; ++k) {
+                    __m128 const edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[k]), sx), _mm_set1_ps(row[k]));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, in));
+                    covered = _mm_and_ps(covered, _mm_cmpge_ps(edge, out));
+                }
+                if (_mm_movemask_ps(covered) == 0) {
+                    continue;
+                }
+                __m128 const oldSecond = _mm_loadu_ps(second + i);
+                if (!placed) {
+                    _mm_storeu_ps(second + i, select(covered, infinity, oldSecond));
+                    continue;
+                }
+                __m128 const depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(primitive.DepthA), sx), _mm_set1_ps(rowDepth));
+
+                __m128 const oldInner = _mm_loadu_ps(inner + i);
+                __m128 const nearerInner = _mm_and_ps(inside, _mm_cmpgt_ps(depth, oldInner));
+                _mm_storeu_ps(inner + i, select(nearerInner, depth, oldInner));
+                __m128i* innerSlot = reinterpret_cast<__m128i*>(innerSlots + i);
+                _mm_storeu_si128(innerSlot, select(nearerInner, slot, _mm_loadu_si128(innerSlot)));
+
+                // The outer triangle it displaces, or else the triangle itself, may become the second
+                __m128 const oldOuter = _mm_loadu_ps(outer + i);
+                __m128i* outerSlot = reinterpret_cast<__m128i*>(outerSlots + i);
+                __m128i const oldSlots = _mm_loadu_si128(outerSlot);
+                __m128 const nearer = _mm_and_ps(covered, _mm_cmpgt_ps(depth, oldOuter));
+                __m128 const other = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(oldSlots, slot)), covered);
+                __m128 const behind = select(nearer, oldOuter, depth);
+                __m128 const next = select(other, _mm_max_ps(oldSecond, behind), oldSecond);
+                __m128 const vouched = _mm_and_ps(_mm_cmpge_ps(depth, low), _mm_cmple_ps(depth, high));
+                _mm_storeu_ps(second + i, select(_mm_andnot_ps(vouched, covered), infinity, next));
+                _mm_storeu_ps(outer + i, select(nearer, depth, oldOuter));
+                _mm_storeu_si128(outerSlot, select(nearer, slot, oldSlots));
+            }
+            #else
+            for (; x <= x1; ++x) {
+                std::size_t const i = x - tile.X;
+                float const sx = static_cast<float>(x - primitive.MinX) + sample.X;
+                float const edges[3] = {a[0] * sx + row[0], a[1] * sx + row[1], a[2] * sx + row[2]};
+                if (edges[0] < -margin || edges[1] < -margin || edges[2] < -margin) {
+                    continue;
+                }
+                if (!placed) {
+                    second[i] = Infinity;
+                    continue;
+                }
+                float const depth = primitive.DepthA * sx + rowDepth;
+                if (edges[0] >= margin && edges[1] >= margin && edges[2] >= margin && depth > inner[i]) {
+                    inner[i] = depth;
+                    innerSlots[i] = primitive.Slot;
+                }
+                if (outerSlots[i] != primitive.Slot) {
+                    second[i] = std::max(second[i], depth > outer[i] ? outer[i] : depth);
+                }
+                if (!(depth >= primitive.DepthLow && depth <= primitive.DepthHigh)) {
+                    second[i] = Infinity;
+                }
+                if (depth > outer[i]) {
+                    outer[i] = depth;
+                    outerSlots[i] = primitive.Slot;
+                }
+            }
+            #endif
+        }
+    }
+}  // namespace rt
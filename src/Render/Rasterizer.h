@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Camera/Camera.h"
+#include "../Engine/Engine.h"
+#include "../Engine/Tools.h"
+
+namespace rt {
+    // Visibility buffer for the camera rays of one view. Setup places the triangles a camera ray
+    // may hit on the screen and sorts them into square bins. Resolve then rasterizes a tile at the
+    // sample positions of one sample index, giving the slot of the nearest triangle under each ray.
+    //
+    // Coverage is tested twice, with every edge moved Margin pixels in and then out. A sample is
+    // settled when the same triangle is nearest both ways and every other triangle covering it with
+    // the edges moved out lies clearly behind, or when nothing covers it at all. The margins cover
+    // the rounding of the ray test, so it then hits that triangle, or nothing, just as traversal would.
+    class Rasterizer {
+    public:
+        // Depths and slots of the samples of a tile, reused from one Resolve to the next
+        struct Buffer {
+            std::vector<float>          Inner;
+            std::vector<std::uint32_t>  InnerSlots;
+            std::vector<float>          Outer;
+            std::vector<std::uint32_t>  OuterSlots;
+            // Nearest depth covered by a triangle other than the outer one, infinite where a
+            // triangle the rasterizer cannot vouch for may cover the sample
+            std::vector<float>          Second;
+        };
+
+        explicit    Rasterizer(Engine const& engine);
+
+        void        Setup(Camera const& camera);
+        // One sample per pixel of the tile, row-major as GenerateRays orders its rays
+        void        Resolve(Tile const& tile, unsigned int sampleIndex, std::vector<VisibilitySample>& samples,
+                            Buffer& buffer) const;
+
+        static constexpr unsigned int   BinSize = 32;
+        static constexpr float          Margin = 1.f / 32.f;
+        // Other triangles must lie this fraction of the depth further away
+        static constexpr float          DepthMargin = 1.f / 64.f;
+
+    private:
+        // Edge functions A x + B y + C in pixels from the edge, not negative inside, and the plane of
+        // 1 / Z, which grows towards the camera, both relative to pixel (MinX, MinY). They come from
+        // the camera's ray directions rather than projected corners, so triangles reaching behind the
+        // camera need no clipping. Margin adds what the ray test may round away to the class Margin,
+        // and samples covered at a depth outside [DepthLow, DepthHigh] are left to the tracer. The
+        // pixel rectangle holds every sample the triangle may cover. A primitive without a slot only
+        // marks the samples around a triangle that could not be rasterized.
+        struct Primitive {
+            float           EdgeA[3];
+            float           EdgeB[3];
+            float           EdgeC[3];
+            float           DepthA = 0.f;
+            float           DepthB = 0.f;
+            float           DepthC = 0.f;
+            float           DepthLow = 0.f;
+            float           DepthHigh = 0.f;
+            float           Margin = 0.f;
+            std::uint32_t   Slot = 0;
+            unsigned int    MinX = 0;
+            unsigned int    MinY = 0;
+            unsigned int    MaxX = 0;
+            unsigned int    MaxY = 0;
+        };
+
+        Engine const&                               _engine;
+        Camera                                      _camera;
+        Vector2<unsigned int>                       _res;
+        Vector3<double>                             _eye;
+        Vector3<double>                             _pixelDX;
+        Vector3<double>                             _pixelDY;
+        Vector3<double>                             _corner;
+        double                                      _reach = 0.0;
+        unsigned int                                _binsX = 0;
+        unsigned int                                _binsY = 0;
+        // False once a triangle could not be placed at all, leaving every sample to the tracer
+        bool                                        _settles = true;
+        std::vector<std::uint32_t>                  _slots;
+        std::vector<Primitive>                      _primitives;
+        std::vector<std::vector<std::uint32_t>>     _bins;
+
+        void    _project(std::uint32_t slot);
+        // Adds the triangle at slot, whose part in front of the camera projects within the bounds
+        // and reaches nearest in Z
+        void    _add(std::uint32_t slot, double minX, double maxX, double minY, double maxY, double nearest);
+        void    _bin(Primitive const& primitive);
+        void    _rasterize(Primitive const& primitive, Tile const& tile, Vector2<float> const& sample, Buffer& buffer) const;
+    };
+}  // namespace rt
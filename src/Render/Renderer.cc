@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "Renderer.h"
+
+namespace rt {
+    namespace {
+        static_assert(Frame::TileSize % Renderer::PreviewBlock == 0, "preview blocks must not straddle tiles");
+
+        // Edge of the block a pixel stands for while refining: the largest power of two its coordinates are multiples of
+        unsigned int blockSize(unsigned int x, unsigned int y) {
+            for (unsigned int block = Renderer::PreviewBlock; block > 1; block /= 2) {
+                if ((x | y) % block == 0) {
+                    return block;
+                }
+            }
+            return 1;
+        }
+    }
+
+    Renderer::Renderer(Engine const& engine, unsigned int threadCount) : _engine(engine), _displayRes(engine.GetRes()),
+        _size(0), _pool(threadCount), _cameraVersion(0), _latest(nullptr), _frameIndex(0),
+        _refined(0), _targetFrameTime(0.f), _scale(1.f), _running(false) {
+        _cameras.assign(_pool.GetThreadCount() + 1, *engine.GetCamera());
+        _rays.resize(_cameras.size());
+        _colors.resize(_cameras.size());
+        _setRes(_displayRes);
+    }
+
+    Renderer::~Renderer() {
+        Stop();
+    }
+
+    void Renderer::Start() {
+        if (_running.exchange(true)) {
+            return;
+        }
+        _thread = std::thread(&Renderer::_run, this);
+    }
+
+    void Renderer::Stop() {
+        _running = false;
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    CameraState& Renderer::GetCameraState() {
+        return _cameraState;
+    }
+
+    TripleBuffer<Frame>& Renderer::GetFrames() {
+        return _frames;
+    }
+
+    Profiler& Renderer::GetProfiler() {
+        return _profiler;
+    }
+
+    FrameBudget& Renderer::GetFrameBudget() {
+        return _budget;
+    }
+
+    void Renderer::SetTargetFrameTime(float milliseconds) {
+        _targetFrameTime = milliseconds;
+    }
+
+    void Renderer::_run() {
+        while (_running.load(std::memory_order_relaxed)) {
+            auto const start = std::chrono::steady_clock::now();
+            Frame& frame = _frames.Back();
+            std::uint64_t index = _frameIndex + 1;
+            {
+                Profiler::Scope scope(_profiler, Profiler::Copy);
+                if (frame.Res != _res) {
+                    frame.Resize(_res);
+                }
+                bool moved = _syncCamera(index);
+                if (_targetFrameTime > 0.f) {
+                    // a full pass rewrites every tile
+                } else if (moved) {
+                    frame.Clear();
+                } else {
+                    _catchUp(frame);
+                }
+            }
+            std::size_t rays = 0;
+            float traceTime = 0.f;
+            if (_targetFrameTime > 0.f) {
+                traceTime = _tracePass(frame, index);
+                rays = _size;
+                _publish(frame, index);
+                _updateScale(traceTime);
+            } else {
+                auto const traceStart = std::chrono::steady_clock::now();
+                rays = _traceBatch(frame, index);
+                traceTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - traceStart).count();
+                _publish(frame, index);
+            }
+            _budget.Record(rays, traceTime, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    void Renderer::_setRes(Vector2<unsigned int> const& res) {
+        _res = res;
+        _size = static_cast<std::size_t>(_res.X) * _res.Y;
+        _budget.SetSampleLimit(_size);
+        _disY = std::normal_distribution<double>(_res.Y / 2, _res.Y / 2);
+        _disX = std::normal_distribution<double>(_res.X / 2, _res.X / 2);
+        for (auto& camera : _cameras) {
+            camera.SetRes(_res);
+        }
+        Frame layout;
+        layout.Resize(_res);
+        _tileStamps.assign(layout.TileStamps.size(), _frameIndex + 1);
+
+        _refineOrder.clear();
+        _refineOrder.reserve(_size);
+        _levelEnds.clear();
+        for (unsigned int block = PreviewBlock; block > 0; block /= 2) {
+            for (unsigned int y = 0; y < _res.Y; y += block) {
+                for (unsigned int x = 0; x < _res.X; x += block) {
+                    if (blockSize(x, y) == block) {
+                        _refineOrder.push_back(y * _res.X + x);
+                    }
+                }
+            }
+            _levelEnds.push_back(_refineOrder.size());
+        }
+        _refined = 0;
+    }
+
+    bool Renderer::_syncCamera(std::uint64_t index) {
+        VersionedPose pose;
+        if (!_cameraState.Load(pose)) {
+            return false;
+        }
+        for (auto& camera : _cameras) {
+            camera.SetPose(pose.Pose);
+        }
+        _cameraVersion = pose.Version;
+        std::fill(_tileStamps.begin(), _tileStamps.end(), index);
+        _refined = 0;
+        return true;
+    }
+
+    void Renderer::_catchUp(Frame& frame) {
+        if (_latest == nullptr) {
+            return;
+        }
+        for (std::size_t tile = 0; tile < _tileStamps.size(); ++tile) {
+            if (_tileStamps[tile] > frame.Index) {
+                frame.CopyTile(*_latest, tile);
+            }
+        }
+    }
+
+    std::size_t Renderer::_samplePixel() {
+        long long y = static_cast<long long>(_disY(_gen));
+        long long x = static_cast<long long>(_disX(_gen));
+        long long current = (y * _res.X + x) % static_cast<long long>(_size);
+        return static_cast<std::size_t>(current < 0 ? current + _size : current);
+    }
+
+    std::size_t Renderer::_traceBatch(Frame& frame, std::uint64_t index) {
+        Profiler::Scope scope(_profiler, Profiler::Trace);
+        if (_refined < _refineOrder.size()) {
+            return _refine(frame, index);
+        }
+        _samples.resize(_budget.GetSampleCount());
+        for (auto& sample : _samples) {
+            sample = _samplePixel();
+        }
+        // Unique samples let the workers write into the frame without racing each other
+        std::sort(_samples.begin(), _samples.end());
+        _samples.erase(std::unique(_samples.begin(), _samples.end()), _samples.end());
+        for (auto sample : _samples) {
+            _tileStamps[frame.TileOf(sample)] = index;
+        }
+        _pool.ParallelFor(_samples.size(), 256, [this, &frame](std::size_t begin, std::size_t end) {
+            Camera& camera = _cameras[_pool.CurrentWorker()];
+            for (std::size_t i = begin; i < end; ++i) {
+                Vector2<unsigned int> pixel(_samples[i] % _res.X, _samples[i] / _res.X);
+                frame.SetPixel(_samples[i], _engine.Raytrace(camera.GenerateRay(pixel)));
+            }
+        });
+        return _samples.size();
+    }
+
+    // The whole coarsest level goes into one frame, whatever the budget, so the first frame after a
+    // move is already complete. The finer levels then take the budgeted number of samples per frame.
+    // A batch never runs past the end of its level: a coarser block covers pixels of the finer levels,
+    // and tracing both in one ParallelFor would race on those pixels.
+    std::size_t Renderer::_refine(Frame& frame, std::uint64_t index) {
+        std::size_t const first = _refined;
+        std::size_t const levelEnd = *std::upper_bound(_levelEnds.begin(), _levelEnds.end(), first);
+        std::size_t const count = first < _levelEnds.front() ? levelEnd - first
+                                : std::min(_budget.GetSampleCount(), levelEnd - first);
+        _refined += count;
+        for (std::size_t i = first; i < first + count; ++i) {
+            _tileStamps[frame.TileOf(_refineOrder[i])] = index;
+        }
+        _pool.ParallelFor(count, 256, [this, &frame, first](std::size_t begin, std::size_t end) {
+            Camera& camera = _cameras[_pool.CurrentWorker()];
+            for (std::size_t i = first + begin; i < first + end; ++i) {
+                Vector2<unsigned int> const pixel(_refineOrder[i] % _res.X, _refineOrder[i] / _res.X);
+                Color const color = _engine.Raytrace(camera.GenerateRay(pixel));
+                unsigned int const block = blockSize(pixel.X, pixel.Y);
+                unsigned int const width = std::min(block, _res.X - pixel.X);
+                unsigned int const height = std::min(block, _res.Y - pixel.Y);
+                for (unsigned int row = 0; row < height; ++row) {
+                    for (unsigned int col = 0; col < width; ++col) {
+                        frame.SetPixel(_refineOrder[i] + static_cast<std::size_t>(row) * _res.X + col, color);
+                    }
+                }
+            }
+        });
+        return count;
+    }
+
+    float Renderer::_tracePass(Frame& frame, std::uint64_t index) {
+        Profiler::Scope scope(_profiler, Profiler::Trace);
+        auto const start = std::chrono::steady_clock::now();
+        _pool.ParallelFor(_tileStamps.size(), 1, [this, &frame](std::size_t begin, std::size_t end) {
+            unsigned int const worker = _pool.CurrentWorker();
+            RayBuffer& rays = _rays[worker];
+            std::vector<Color>& colors = _colors[worker];
+            for (std::size_t tile = begin; tile < end; ++tile) {
+                Tile const rect = frame.GetTile(tile);
+                _cameras[worker].GenerateRays(rect, 0, rays);
+                _engine.Raytrace(rays, colors);
+                for (unsigned int row = 0; row < rect.Height; ++row) {
+                    std::size_t const pixel = static_cast<std::size_t>(rect.Y + row) * _res.X + rect.X;
+                    for (unsigned int col = 0; col < rect.Width; ++col) {
+                        frame.SetPixel(pixel + col, colors[row * rect.Width + col]);
+                    }
+                }
+            }
+        });
+        std::fill(_tileStamps.begin(), _tileStamps.end(), index);
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void Renderer::_updateScale(float elapsed) {
+        // Traced time grows with the pixel count, i.e. with the square of the scale
+        float scale = _scale * std::sqrt(_targetFrameTime / std::max(elapsed, 0.01f));
+        scale = std::min(std::max(scale, MinScale), 1.f);
+        if (std::abs(scale - _scale) < 0.05f) {
+            return;
+        }
+        _scale = scale;
+        _setRes(Vector2<unsigned int>(std::max(1u, static_cast<unsigned int>(_displayRes.X * _scale)),
+                                      std::max(1u, static_cast<unsigned int>(_displayRes.Y * _scale))));
+    }
+
+    void Renderer::_publish(Frame& frame, std::uint64_t index) {
+        frame.TileStamps = _tileStamps;
+        frame.CameraVersion = _cameraVersion;
+        frame.Index = index;
+        _frameIndex = index;
+        _latest = &frame;
+        _frames.Publish();
+    }
+}  // namespace rt
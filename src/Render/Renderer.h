@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../Camera/Camera.h"
+#include "../Engine/Color.h"
+#include "../Engine/Engine.h"
+#include "../Engine/Profiler.h"
+#include "CameraState.h"
+#include "Frame.h"
+#include "FrameBudget.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
+
+namespace rt {
+    // Traces batches of random pixel samples, sized by a FrameBudget, on a worker pool and publishes packed frames
+    // through a triple buffer, so the UI thread only has to upload and present.
+    // After every camera move the image is first refined coarse to fine: one pixel in PreviewBlock^2
+    // is traced and fills its block, then blocks of half the size, down to single pixels.
+    // Workers write straight into the back frame; before that, only the tiles that
+    // changed since the back frame was last published are copied over from the latest one.
+    // With a target frame time set, every frame is instead a full pass over the image at an
+    // internal resolution that is scaled each frame to hold that target.
+    class Renderer {
+    public:
+        explicit    Renderer(Engine const& engine, unsigned int threadCount = std::thread::hardware_concurrency());
+        ~Renderer();
+
+        Renderer(Renderer const&) = delete;
+        Renderer& operator=(Renderer const&) = delete;
+
+        void                    Start();
+        void                    Stop();
+
+        CameraState&            GetCameraState();
+        TripleBuffer<Frame>&    GetFrames();
+        Profiler&               GetProfiler();
+        FrameBudget&            GetFrameBudget();
+        void                    SetTargetFrameTime(float milliseconds);
+
+        static constexpr float          MinScale = 0.25f;
+        // Block edge of the coarsest preview level, a power of two dividing Frame::TileSize
+        static constexpr unsigned int   PreviewBlock = 4;
+
+    private:
+        Engine const&                       _engine;
+        Vector2<unsigned int>               _displayRes;
+        Vector2<unsigned int>               _res;
+        std::size_t                         _size;
+        ThreadPool                          _pool;
+        std::vector<Camera>                 _cameras;
+        CameraState                         _cameraState;
+        std::uint64_t                       _cameraVersion;
+        TripleBuffer<Frame>                 _frames;
+        Frame const*                        _latest;
+        std::uint64_t                       _frameIndex;
+        std::vector<std::uint64_t>          _tileStamps;
+        std::vector<std::size_t>            _samples;
+        // Pixels in coarse-to-fine order and the end of each block size's run in it, coarsest first
+        std::vector<std::uint32_t>          _refineOrder;
+        std::vector<std::size_t>            _levelEnds;
+        std::size_t                         _refined;
+        std::vector<RayBuffer>              _rays;
+        std::vector<std::vector<Color>>     _colors;
+        float                               _targetFrameTime;
+        float                               _scale;
+        Profiler                            _profiler;
+        FrameBudget                         _budget;
+        std::mt19937                        _gen;
+        std::normal_distribution<double>    _disY;
+        std::normal_distribution<double>    _disX;
+        std::atomic<bool>                   _running;
+        std::thread                         _thread;
+
+        void            _run();
+        void            _setRes(Vector2<unsigned int> const& res);
+        bool            _syncCamera(std::uint64_t index);
+        void            _catchUp(Frame& frame);
+        std::size_t     _samplePixel();
+        std::size_t     _traceBatch(Frame& frame, std::uint64_t index);
+        std::size_t     _refine(Frame& frame, std::uint64_t index);
+        float           _tracePass(Frame& frame, std::uint64_t index);
+        void            _updateScale(float elapsed);
+        void            _publish(Frame& frame, std::uint64_t index);
+    };
+}  // namespace rt
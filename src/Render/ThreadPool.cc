@@ -0,0 +1,114 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+namespace rt {
+    namespace {
+        thread_local ThreadPool const*  currentPool = nullptr;
+        thread_local unsigned int       currentWorker = 0;
+    }
+
+    ThreadPool::ThreadPool(unsigned int threadCount) : ThreadPool(threadCount, WorkerStart()) {
+    }
+
+    ThreadPool::ThreadPool(unsigned int threadCount, WorkerStart onStart) : _onStart(std::move(onStart)), _stop(false) {
+        threadCount = std::max(threadCount, 1u);
+        for (unsigned int i = 0; i < threadCount; ++i) {
+            _threads.emplace_back(&ThreadPool::_worker, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    unsigned int ThreadPool::GetThreadCount() const {
+        return static_cast<unsigned int>(_threads.size());
+    }
+
+    unsigned int ThreadPool::CurrentWorker() const {
+        return currentPool == this ? currentWorker : GetThreadCount();
+    }
+
+    void ThreadPool::ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> const& body) {
+        grain = std::max<std::size_t>(grain, 1);
+        TaskGroup group(*this);
+        for (std::size_t begin = 0; begin < count; begin += grain) {
+            std::size_t end = std::min(begin + grain, count);
+            group.Run([&body, begin, end]() { body(begin, end); });
+        }
+        group.Wait();
+    }
+
+    void ThreadPool::_push(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+        _cv.notify_one();
+    }
+
+    bool ThreadPool::_runOne() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_tasks.empty()) {
+                return false;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+        return true;
+    }
+
+    void ThreadPool::_worker(unsigned int index) {
+        currentPool = this;
+        currentWorker = index;
+        if (_onStart) {
+            _onStart(index);
+        }
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+                if (_stop && _tasks.empty()) {
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    TaskGroup::TaskGroup(ThreadPool& pool) : _pool(pool), _pending(0) {
+    }
+
+    TaskGroup::~TaskGroup() {
+        Wait();
+    }
+
+    void TaskGroup::Run(std::function<void()> task) {
+        _pending.fetch_add(1, std::memory_order_relaxed);
+        _pool._push([this, task = std::move(task)]() {
+            task();
+            _pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    void TaskGroup::Wait() {
+        while (_pending.load(std::memory_order_acquire) != 0) {
+            if (!_pool._runOne()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+}  // namespace rt
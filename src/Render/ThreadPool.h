@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rt {
+    class ThreadPool {
+    public:
+        // Runs on each worker thread before it takes tasks, e.g. to pin it to CPUs
+        using WorkerStart = std::function<void(unsigned int)>;
+
+        explicit    ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+        ThreadPool(unsigned int threadCount, WorkerStart onStart);
+        ~ThreadPool();
+
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        unsigned int    GetThreadCount() const;
+        void            ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> const& body);
+
+        // Index of the calling pool thread, or GetThreadCount() for any other thread,
+        // so per-thread scratch arrays need GetThreadCount() + 1 slots.
+        unsigned int    CurrentWorker() const;
+
+    private:
+        friend class TaskGroup;
+
+        WorkerStart                         _onStart;
+        std::vector<std::thread>            _threads;
+        std::deque<std::function<void()>>   _tasks;
+        std::mutex                          _mutex;
+        std::condition_variable             _cv;
+        bool                                _stop;
+
+        void    _push(std::function<void()> task);
+        bool    _runOne();
+        void    _worker(unsigned int index);
+    };
+
+    // Fork-join helper: Wait() executes queued tasks while it waits, so groups may nest.
+    class TaskGroup {
+    public:
+        explicit    TaskGroup(ThreadPool& pool);
+        ~TaskGroup();
+
+        void    Run(std::function<void()> task);
+        void    Wait();
+
+    private:
+        ThreadPool&                 _pool;
+        std::atomic<std::size_t>    _pending;
+    };
+}  // namespace rt
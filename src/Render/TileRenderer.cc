@@ -0,0 +1,60 @@
+#include <algorithm>
+#include "TileRenderer.h"
+
+namespace rt {
+    TileRenderer::TileRenderer(Engine const& engine, ThreadPool& pool) : _engine(engine), _pool(pool),
+        _scratch(pool.GetThreadCount() + 1), _rasterizer(engine) {
+    }
+
+    void TileRenderer::Render(Camera const& camera, Tile const& region, unsigned int spp, std::uint8_t* rgba, std::size_t stride) {
+        unsigned int const blocksX = (region.Width + BlockSize - 1) / BlockSize;
+        unsigned int const blocksY = (region.Height + BlockSize - 1) / BlockSize;
+        if (_rasterize) {
+            _rasterizer.Setup(camera);
+        }
+        _pool.ParallelFor(static_cast<std::size_t>(blocksX) * blocksY, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                unsigned int x = static_cast<unsigned int>(i % blocksX) * BlockSize;
+                unsigned int y = static_cast<unsigned int>(i / blocksX) * BlockSize;
+                Tile block(region.X + x, region.Y + y, std::min(BlockSize, region.Width - x), std::min(BlockSize, region.Height - y));
+                RenderBlock(camera, block, spp, rgba + y * stride + x * 4, stride, _rasterize ? &_rasterizer : nullptr);
+            }
+        });
+    }
+
+    void TileRenderer::SetReplicas(EngineReplicas const* replicas) {
+        _replicas = replicas;
+    }
+
+    void TileRenderer::RenderBlock(Camera const& camera, Tile const& block, unsigned int spp, std::uint8_t* rgba, std::size_t stride,
+                                   Rasterizer const* visibility) {
+        unsigned int const worker = _pool.CurrentWorker();
+        Engine const& engine = _replicas != nullptr ? _replicas->For(worker) : _engine;
+        Scratch& scratch = _scratch[worker];
+        scratch.Sums.assign(static_cast<std::size_t>(block.Width) * block.Height, Vector3<float>());
+        for (unsigned int sample = 0; sample < spp; ++sample) {
+            camera.GenerateRays(block, sample, scratch.Rays);
+            if (visibility != nullptr) {
+                visibility->Resolve(block, sample, scratch.Visibility, scratch.Raster);
+                engine.Raytrace(scratch.Rays, scratch.Visibility, scratch.Colors);
+            } else {
+                engine.Raytrace(scratch.Rays, scratch.Colors);
+            }
+            for (std::size_t i = 0; i < scratch.Colors.size(); ++i) {
+                Color_Component const components = scratch.Colors[i].GetColor();
+                scratch.Sums[i] = scratch.Sums[i] + Vector3<float>(components.rgba.r, components.rgba.g, components.rgba.b);
+            }
+        }
+        float const scale = 1.f / std::max(spp, 1u);
+        for (unsigned int row = 0; row < block.Height; ++row) {
+            std::uint8_t* dst = rgba + row * stride;
+            for (unsigned int col = 0; col < block.Width; ++col) {
+                Vector3<float> const color = scratch.Sums[row * block.Width + col] * scale;
+                dst[col * 4] = static_cast<std::uint8_t>(color.X + 0.5f);
+                dst[col * 4 + 1] = static_cast<std::uint8_t>(color.Y + 0.5f);
+                dst[col * 4 + 2] = static_cast<std::uint8_t>(color.Z + 0.5f);
+                dst[col * 4 + 3] = 255;
+            }
+        }
+    }
+}  // namespace rt
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Camera/Camera.h"
+#include "../Camera/RayBuffer.h"
+#include "../Engine/Color.h"
+#include "../Engine/Engine.h"
+#include "../Engine/Numa.h"
+#include "../Vector/Vector3.h"
+#include "Rasterizer.h"
+#include "ThreadPool.h"
+
+namespace rt {
+    // Renders a region with a fixed number of samples per pixel, split into
+    // blocks spread over the pool, and writes the averaged result as packed RGBA.
+    class TileRenderer {
+    public:
+        TileRenderer(Engine const& engine, ThreadPool& pool);
+
+        void    Render(Camera const& camera, Tile const& region, unsigned int spp, std::uint8_t* rgba, std::size_t stride);
+        // Renders one block on the calling thread, for callers that schedule blocks themselves. A
+        // rasterizer set up for the camera starts each camera ray from its visibility buffer.
+        void    RenderBlock(Camera const& camera, Tile const& block, unsigned int spp, std::uint8_t* rgba, std::size_t stride,
+                            Rasterizer const* visibility = nullptr);
+        // Traces each worker's blocks with its node's copy of the engine, null to use the engine itself
+        void    SetReplicas(EngineReplicas const* replicas);
+        // Rasterizes each view Render draws before tracing it
+        void    SetRasterization(bool enabled) { _rasterize = enabled; }
+
+        static constexpr unsigned int BlockSize = 16;
+
+    private:
+        struct Scratch {
+            RayBuffer                       Rays;
+            std::vector<Color>              Colors;
+            std::vector<Vector3<float>>     Sums;
+            std::vector<VisibilitySample>   Visibility;
+            Rasterizer::Buffer              Raster;
+        };
+
+        Engine const&           _engine;
+        EngineReplicas const*   _replicas = nullptr;
+        ThreadPool&             _pool;
+        std::vector<Scratch>    _scratch;
+        Rasterizer              _rasterizer;
+        bool                    _rasterize = false;
+    };
+}  // namespace rt
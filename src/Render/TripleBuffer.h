@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rt {
+    // Single-producer / single-consumer triple buffer. The producer fills Back()
+    // and publishes it; the consumer picks up the most recently published buffer
+    // with Update(). Neither side ever blocks, intermediate buffers may be skipped.
+    template <class T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() : _middle(1), _back(0), _front(2) {};
+
+        T&  Back() {
+            return _buffers[_back];
+        }
+
+        void    Publish() {
+            std::uint8_t previous = _middle.exchange(_back | FreshBit, std::memory_order_acq_rel);
+            _back = previous & IndexMask;
+        }
+
+        bool    Update() {
+            if (!(_middle.load(std::memory_order_relaxed) & FreshBit)) {
+                return false;
+            }
+            std::uint8_t previous = _middle.exchange(_front, std::memory_order_acq_rel);
+            _front = previous & IndexMask;
+            return true;
+        }
+
+        T const&    Front() const {
+            return _buffers[_front];
+        }
+
+    private:
+        static constexpr std::uint8_t IndexMask = 0x3;
+        static constexpr std::uint8_t FreshBit = 0x4;
+
+        std::array<T, 3>            _buffers;
+        std::atomic<std::uint8_t>   _middle;
+        std::uint8_t                _back;
+        std::uint8_t                _front;
+    };
+}  // namespace rt
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <iostream>
+#include "VideoWriter.h"
+
+namespace rt {
+    bool VideoWriter::Open(std::string const& path, Vector2<unsigned int> const& res, unsigned int fps) {
+        _out.open(path, std::ios::binary);
+        if (!_out) {
+            std::cerr << "Cannot write video " << path << std::endl;
+            return false;
+        }
+        _res = res;
+        _out << "YUV4MPEG2 W" << res.X << " H" << res.Y << " F" << std::max(fps, 1u) << ":1 Ip A1:1 C420jpeg\n";
+        return static_cast<bool>(_out);
+    }
+
+    bool VideoWriter::Write(Image const& image) {
+        if (image.Res != _res) {
+            return false;
+        }
+        unsigned int const chromaX = (_res.X + 1) / 2;
+        unsigned int const chromaY = (_res.Y + 1) / 2;
+        std::size_t const lumaSize = static_cast<std::size_t>(_res.X) * _res.Y;
+        std::size_t const chromaSize = static_cast<std::size_t>(chromaX) * chromaY;
+        _planes.resize(lumaSize + 2 * chromaSize);
+        std::uint8_t* luma = _planes.data();
+        std::uint8_t* cb = luma + lumaSize;
+        std::uint8_t* cr = cb + chromaSize;
+
+        // JFIF / BT.601 full-range coefficients
+        for (unsigned int y = 0; y < _res.Y; ++y) {
+            std::uint8_t const* src = &image.Pixels[y * image.GetStride()];
+            for (unsigned int x = 0; x < _res.X; ++x) {
+                float const value = 0.299f * src[x * 4] + 0.587f * src[x * 4 + 1] + 0.114f * src[x * 4 + 2];
+                luma[y * _res.X + x] = static_cast<std::uint8_t>(std::min(value + 0.5f, 255.f));
+            }
+        }
+        for (unsigned int y = 0; y < chromaY; ++y) {
+            for (unsigned int x = 0; x < chromaX; ++x) {
+                // Average the 2x2 block, clamped at odd edges
+                float r = 0.f, g = 0.f, b = 0.f;
+                for (unsigned int dy = 0; dy < 2; ++dy) {
+                    for (unsigned int dx = 0; dx < 2; ++dx) {
+                        unsigned int const px = std::min(x * 2 + dx, _res.X - 1);
+                        unsigned int const py = std::min(y * 2 + dy, _res.Y - 1);
+                        std::uint8_t const* src = &image.Pixels[py * image.GetStride() + px * 4];
+                        r += src[0];
+                        g += src[1];
+                        b += src[2];
+                    }
+                }
+                r *= 0.25f;
+                g *= 0.25f;
+                b *= 0.25f;
+                float const u = 128.f - 0.168736f * r - 0.331264f * g + 0.5f * b;
+                float const v = 128.f + 0.5f * r - 0.418688f * g - 0.081312f * b;
+                cb[y * chromaX + x] = static_cast<std::uint8_t>(std::min(std::max(u + 0.5f, 0.f), 255.f));
+                cr[y * chromaX + x] = static_cast<std::uint8_t>(std::min(std::max(v + 0.5f, 0.f), 255.f));
+            }
+        }
+        _out << "FRAME\n";
+        _out.write(reinterpret_cast<char const*>(_planes.data()), _planes.size());
+        return static_cast<bool>(_out);
+    }
+}  // namespace rt
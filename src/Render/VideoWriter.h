@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Image.h"
+
+namespace rt {
+    // Streams frames as uncompressed YUV4MPEG2 (4:2:0, full range), which ffmpeg and most players read directly.
+    class VideoWriter {
+    public:
+        bool    Open(std::string const& path, Vector2<unsigned int> const& res, unsigned int fps);
+        bool    Write(Image const& image);
+
+    private:
+        std::ofstream               _out;
+        Vector2<unsigned int>       _res;
+        std::vector<std::uint8_t>   _planes;
+    };
+}  // namespace rt
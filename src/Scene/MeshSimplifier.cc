@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "MeshSimplifier.h"
+
+namespace rt {
+    namespace {
+        using PositionKey = std::array<std::uint32_t, 3>;
+
+        PositionKey positionKey(Vector3<float> const& position) {
+            PositionKey key;
+            std::memcpy(&key[0], &position.X, sizeof(float));
+            std::memcpy(&key[1], &position.Y, sizeof(float));
+            std::memcpy(&key[2], &position.Z, sizeof(float));
+            return key;
+        }
+
+        std::uint64_t edgeKey(std::uint32_t a, std::uint32_t b) {
+            return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+        }
+    }
+
+    void MeshSimplifier::Quadric::AddPlane(Vector3<float> const& normal, float distance, double weight) {
+        double const a = normal.X;
+        double const b = normal.Y;
+        double const c = normal.Z;
+        double const d = distance;
+        double const plane[10] = {a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+        for (int i = 0; i < 10; ++i) {
+            Values[i] += plane[i] * weight;
+        }
+        Weight += weight;
+    }
+
+    void MeshSimplifier::Quadric::Add(Quadric const& other) {
+        for (int i = 0; i < 10; ++i) {
+            Values[i] += other.Values[i];
+        }
+        Weight += other.Weight;
+    }
+
+    double MeshSimplifier::Quadric::Evaluate(Vector3<float> const& point) const {
+        double const x = point.X;
+        double const y = point.Y;
+        double const z = point.Z;
+        double const* q = Values;
+        double const value = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+                           + q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+                           + q[7] * z * z + 2.0 * q[8] * z + q[9];
+        return std::max(value, 0.0);
+    }
+
+    MeshSimplifier::MeshSimplifier(Span<Triangle const> triangles) {
+        // Weld corners that share a position, whatever their normals, so the mesh is connected
+        std::size_t const corners = triangles.Size() * 3;
+        auto cornerPosition = [&](std::size_t corner) -> Vertex const& {
+            Triangle const& triangle = triangles[corner / 3];
+            return corner % 3 == 0 ? triangle.GetV1() : (corner % 3 == 1 ? triangle.GetV2() : triangle.GetV3());
+        };
+        std::vector<std::pair<PositionKey, std::uint32_t>> sorted(corners);
+        for (std::size_t corner = 0; corner < corners; ++corner) {
+            sorted[corner] = {positionKey(cornerPosition(corner).GetPos()), static_cast<std::uint32_t>(corner)};
+        }
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<std::uint32_t> cornerVertex(corners);
+        for (std::size_t i = 0; i < corners; ++i) {
+            Vertex const& vertex = cornerPosition(sorted[i].second);
+            if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+                _positions.push_back(vertex.GetPos());
+                _normals.emplace_back();
+            }
+            _normals.back() = _normals.back() + vertex.GetNormal();
+            cornerVertex[sorted[i].second] = static_cast<std::uint32_t>(_positions.size() - 1);
+        }
+        for (Vector3<float>& normal : _normals) {
+            if (normal.Norm() > 0.f) {
+                normal.Normalize();
+            }
+        }
+
+        _quadrics.resize(_positions.size());
+        _versions.assign(_positions.size(), 0);
+        _vertexFaces.resize(_positions.size());
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> edges;
+        for (std::size_t t = 0; t < triangles.Size(); ++t) {
+            std::array<std::uint32_t, 3> const face{cornerVertex[3 * t], cornerVertex[3 * t + 1], cornerVertex[3 * t + 2]};
+            Vector3<float> normal = (_positions[face[1]] - _positions[face[0]]).Cross(_positions[face[2]] - _positions[face[0]]);
+            float const area = 0.5f * normal.Norm();
+            if (face[0] == face[1] || face[1] == face[2] || face[0] == face[2] || area == 0.f) {
+                continue;
+            }
+            normal.Normalize();
+            std::uint32_t const index = static_cast<std::uint32_t>(_faces.size());
+            for (std::uint32_t vertex : face) {
+                _quadrics[vertex].AddPlane(normal, -normal.Dot(_positions[face[0]]), area);
+                _vertexFaces[vertex].push_back(index);
+            }
+            for (int corner = 0; corner < 3; ++corner) {
+                edges.emplace_back(edgeKey(face[corner], face[(corner + 1) % 3]), index);
+            }
+            _faces.push_back(face);
+        }
+        _removed.assign(_faces.size(), 0);
+        _liveTriangles = _faces.size();
+
+        // Open edges get a plane perpendicular to their face, so borders only move as far as the surface may
+        std::sort(edges.begin(), edges.end());
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            bool const first = i == 0 || edges[i].first != edges[i - 1].first;
+            bool const last = i + 1 == edges.size() || edges[i].first != edges[i + 1].first;
+            std::uint32_t const a = static_cast<std::uint32_t>(edges[i].first >> 32);
+            std::uint32_t const b = static_cast<std::uint32_t>(edges[i].first);
+            if (first && last) {
+                std::array<std::uint32_t, 3> const& face = _faces[edges[i].second];
+                Vector3<float> const faceNormal = (_positions[face[1]] - _positions[face[0]]).Cross(_positions[face[2]] - _positions[face[0]]);
+                Vector3<float> border = (_positions[b] - _positions[a]).Cross(faceNormal);
+                if (border.Norm() > 0.f) {
+                    border.Normalize();
+                    _quadrics[a].AddPlane(border, -border.Dot(_positions[a]), 0.5f * faceNormal.Norm());
+                    _quadrics[b].AddPlane(border, -border.Dot(_positions[a]), 0.5f * faceNormal.Norm());
+                }
+            }
+            if (first) {
+                _queueEdge(a, b);
+            }
+        }
+    }
+
+    void MeshSimplifier::Simplify(std::size_t targetCount) {
+        while (_liveTriangles > targetCount && !_queue.empty()) {
+            Candidate const candidate = _queue.top();
+            _queue.pop();
+            if (candidate.FromVersion != _versions[candidate.From] || candidate.ToVersion != _versions[candidate.To]
+                || _folds(candidate.From, candidate.To)) {
+                continue;
+            }
+            Quadric merged = _quadrics[candidate.From];
+            merged.Add(_quadrics[candidate.To]);
+            if (merged.Weight > 0.0) {
+                _error = std::max(_error, static_cast<float>(std::sqrt(candidate.Cost / merged.Weight)));
+            }
+            _collapse(candidate.From, candidate.To);
+        }
+    }
+
+    void MeshSimplifier::AppendTriangles(Vector3<float> const& diffuseColor, std::vector<Triangle>& out) const {
+        for (std::size_t f = 0; f < _faces.size(); ++f) {
+            if (_removed[f]) {
+                continue;
+            }
+            std::array<std::uint32_t, 3> const& face = _faces[f];
+            Vertex v1(_positions[face[0]]);
+            Vertex v2(_positions[face[1]]);
+            Vertex v3(_positions[face[2]]);
+            v1.SetNormal(_normals[face[0]]);
+            v2.SetNormal(_normals[face[1]]);
+            v3.SetNormal(_normals[face[2]]);
+            out.emplace_back(v1, v2, v3, diffuseColor);
+        }
+    }
+
+    void MeshSimplifier::_queueEdges(std::uint32_t vertex) {
+        std::vector<std::uint32_t> neighbours;
+        for (std::uint32_t f : _vertexFaces[vertex]) {
+            for (std::uint32_t other : _faces[f]) {
+                if (other != vertex) {
+                    neighbours.push_back(other);
+                }
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (std::uint32_t neighbour : neighbours) {
+            _queueEdge(vertex, neighbour);
+        }
+    }
+
+    // Only the cheaper direction is queued, the edge comes back if a neighbour changes it
+    void MeshSimplifier::_queueEdge(std::uint32_t a, std::uint32_t b) {
+        Quadric quadric = _quadrics[a];
+        quadric.Add(_quadrics[b]);
+        double const toB = quadric.Evaluate(_positions[b]);
+        double const toA = quadric.Evaluate(_positions[a]);
+        Candidate candidate;
+        candidate.Cost = std::min(toA, toB);
+        candidate.From = toB <= toA ? a : b;
+        candidate.To = toB <= toA ? b : a;
+        candidate.FromVersion = _versions[candidate.From];
+        candidate.ToVersion = _versions[candidate.To];
+        _queue.push(candidate);
+    }
+
+    bool MeshSimplifier::_folds(std::uint32_t from, std::uint32_t to) const {
+        for (std::uint32_t f : _vertexFaces[from]) {
+            std::array<std::uint32_t, 3> const& face = _faces[f];
+            if (_removed[f] || std::find(face.begin(), face.end(), to) != face.end()) {
+                continue;
+            }
+            Vector3<float> before[3];
+            Vector3<float> after[3];
+            for (int corner = 0; corner < 3; ++corner) {
+                before[corner] = _positions[face[corner]];
+                after[corner] = face[corner] == from ? _positions[to] : before[corner];
+            }
+            Vector3<float> const oldNormal = (before[1] - before[0]).Cross(before[2] - before[0]);
+            Vector3<float> const newNormal = (after[1] - after[0]).Cross(after[2] - after[0]);
+            float const newArea = newNormal.Norm();
+            if (newArea == 0.f || oldNormal.Dot(newNormal) < MinFaceCosine * oldNormal.Norm() * newArea) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void MeshSimplifier::_collapse(std::uint32_t from, std::uint32_t to) {
+        std::vector<std::uint32_t>& toFaces = _vertexFaces[to];
+        for (std::uint32_t f : _vertexFaces[from]) {
+            if (_removed[f]) {
+                continue;
+            }
+            std::array<std::uint32_t, 3>& face = _faces[f];
+            if (std::find(face.begin(), face.end(), to) != face.end()) {
+                _removed[f] = 1;
+                --_liveTriangles;
+            } else {
+                std::replace(face.begin(), face.end(), from, to);
+                toFaces.push_back(f);
+            }
+        }
+        std::vector<std::uint32_t>().swap(_vertexFaces[from]);
+        toFaces.erase(std::remove_if(toFaces.begin(), toFaces.end(), [&](std::uint32_t f) {
+            return _removed[f] != 0;
+        }), toFaces.end());
+        _quadrics[to].Add(_quadrics[from]);
+        ++_versions[from];
+        ++_versions[to];
+        _queueEdges(to);
+    }
+}  // namespace rt
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include "../Engine/Span.h"
+#include "../Geometry/Geometry.h"
+
+namespace rt {
+    // Quadric error edge collapse (Garland and Heckbert 1997) over the triangles of one object.
+    // Coincident vertices are welded first. Each collapse then moves one end of the cheapest edge
+    // onto the other, so the remaining vertices keep their original positions and normals.
+    // Successive Simplify calls continue from the previous result, which nests the levels.
+    class MeshSimplifier {
+    public:
+        explicit    MeshSimplifier(Span<Triangle const> triangles);
+
+        // Collapses edges until at most targetCount triangles remain or no edge may collapse
+        void        Simplify(std::size_t targetCount);
+        std::size_t GetTriangleCount() const { return _liveTriangles; }
+        // Largest root mean square distance from the original planes around a vertex that a collapse
+        // so far allowed, a measure of how far the surface moved in scene units
+        float       GetError() const { return _error; }
+        void        AppendTriangles(Vector3<float> const& diffuseColor, std::vector<Triangle>& out) const;
+
+        // Collapses turning a face by more than about 78 degrees would fold the surface over
+        static constexpr float  MinFaceCosine = 0.2f;
+
+    private:
+        // Area weighted sum of squared distances to a set of planes, the upper triangle of a
+        // symmetric 4x4 matrix, and the total weight
+        struct Quadric {
+            double  Values[10] = {};
+            double  Weight = 0.0;
+
+            void    AddPlane(Vector3<float> const& normal, float distance, double weight);
+            void    Add(Quadric const& other);
+            double  Evaluate(Vector3<float> const& point) const;
+        };
+
+        // Moves From onto To, stale once either vertex changed after it was queued
+        struct Candidate {
+            double          Cost = 0.0;
+            std::uint32_t   From = 0;
+            std::uint32_t   To = 0;
+            std::uint32_t   FromVersion = 0;
+            std::uint32_t   ToVersion = 0;
+
+            bool    operator>(Candidate const& other) const {
+                return Cost > other.Cost;
+            }
+        };
+
+        std::vector<Vector3<float>>                 _positions;
+        std::vector<Vector3<float>>                 _normals;
+        std::vector<Quadric>                        _quadrics;
+        std::vector<std::uint32_t>                  _versions;
+        // Faces around each vertex, removed ones are only dropped from the vertex a collapse keeps
+        std::vector<std::vector<std::uint32_t>>     _vertexFaces;
+        std::vector<std::array<std::uint32_t, 3>>   _faces;
+        std::vector<std::uint8_t>                   _removed;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> _queue;
+        std::size_t                                 _liveTriangles = 0;
+        float                                       _error = 0.f;
+
+        void    _queueEdges(std::uint32_t vertex);
+        void    _queueEdge(std::uint32_t a, std::uint32_t b);
+        bool    _folds(std::uint32_t from, std::uint32_t to) const;
+        void    _collapse(std::uint32_t from, std::uint32_t to);
+    };
+}  // namespace rt
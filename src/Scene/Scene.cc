@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <iomanip>
+#include "MeshSimplifier.h"
+#include "Scene.h"
+
+namespace rt {
+    std::uint32_t Scene::AddObject(Vector3<float> const& diffuseColor) {
+        SceneObject object;
+        object.FirstTriangle = static_cast<std::uint32_t>(_triangles.size());
+        object.DiffuseColor = diffuseColor;
+        _objects.push_back(object);
+        return static_cast<std::uint32_t>(_objects.size() - 1);
+    }
+
+    void Scene::AddTriangle(Vertex const& v1, Vertex const& v2, Vertex const& v3) {
+        SceneObject& object = _objects.back();
+        _triangles.emplace_back(v1, v2, v3, object.DiffuseColor);
+        ++object.TriangleCount;
+    }
+
+    void Scene::AddLight(PointLight const& light) {
+        _lights.push_back(light);
+    }
+
+    void Scene::SetCamera(Camera const& camera) {
+        _camera = camera;
+    }
+
+    void Scene::GenerateLods(LodOptions const& options) {
+        _lods.clear();
+        _lodTriangles.clear();
+        if (options.MinTriangles == 0) {
+            return;
+        }
+        for (SceneObject& object : _objects) {
+            object.FirstLod = static_cast<std::uint32_t>(_lods.size());
+            object.LodCount = 0;
+            if (object.TriangleCount < options.MinTriangles) {
+                continue;
+            }
+            MeshSimplifier simplifier(Span<Triangle const>(_triangles.data() + object.FirstTriangle, object.TriangleCount));
+            std::size_t previous = object.TriangleCount;
+            while (true) {
+                std::size_t const target = static_cast<std::size_t>(previous * options.Ratio);
+                if (target < options.MinLevelTriangles) {
+                    break;
+                }
+                simplifier.Simplify(target);
+                // Stop once collapses are mostly refused, the level would barely be cheaper
+                if (simplifier.GetTriangleCount() > (previous + target) / 2) {
+                    break;
+                }
+                SceneLod lod;
+                lod.FirstTriangle = static_cast<std::uint32_t>(_lodTriangles.size());
+                simplifier.AppendTriangles(object.DiffuseColor, _lodTriangles);
+                lod.TriangleCount = static_cast<std::uint32_t>(_lodTriangles.size()) - lod.FirstTriangle;
+                lod.Error = simplifier.GetError();
+                _lods.push_back(lod);
+                ++object.LodCount;
+                previous = simplifier.GetTriangleCount();
+            }
+        }
+    }
+
+    void Scene::Shrink() {
+        _objects.shrink_to_fit();
+        _triangles.shrink_to_fit();
+        _lods.shrink_to_fit();
+        _lodTriangles.shrink_to_fit();
+        _lights.shrink_to_fit();
+    }
+
+    void Scene::Clear() {
+        std::vector<SceneObject>().swap(_objects);
+        std::vector<Triangle>().swap(_triangles);
+        std::vector<SceneLod>().swap(_lods);
+        std::vector<Triangle>().swap(_lodTriangles);
+        std::vector<PointLight>().swap(_lights);
+    }
+
+    std::vector<SceneObject> const& Scene::GetObjects() const {
+        return _objects;
+    }
+
+    std::vector<Triangle> const& Scene::GetTriangles() const {
+        return _triangles;
+    }
+
+    std::vector<SceneLod> const& Scene::GetLods() const {
+        return _lods;
+    }
+
+    std::vector<Triangle> const& Scene::GetLodTriangles() const {
+        return _lodTriangles;
+    }
+
+    std::vector<PointLight> const& Scene::GetLights() const {
+        return _lights;
+    }
+
+    Camera const& Scene::GetCamera() const {
+        return _camera;
+    }
+
+    std::size_t Scene::GetMemoryUsage() const {
+        return _objects.capacity() * sizeof(SceneObject) + _triangles.capacity() * sizeof(Triangle)
+             + _lods.capacity() * sizeof(SceneLod) + _lodTriangles.capacity() * sizeof(Triangle)
+             + _lights.capacity() * sizeof(PointLight);
+    }
+
+    void Scene::Report(std::ostream& out) const {
+        out << std::fixed << std::setprecision(2)
+            << "Scene: " << _objects.size() << " objects, " << _triangles.size() << " triangles, " << _lights.size()
+            << " lights, " << GetMemoryUsage() / (1024.f * 1024.f) << " MiB" << std::endl;
+        if (!_lods.empty()) {
+            std::size_t const objects = static_cast<std::size_t>(std::count_if(_objects.begin(), _objects.end(), [](SceneObject const& object) {
+                return object.LodCount > 0;
+            }));
+            out << "Levels of detail: " << _lods.size() << " levels of " << objects << " objects, " << _lodTriangles.size()
+                << " triangles" << std::endl;
+        }
+    }
+}  // namespace rt
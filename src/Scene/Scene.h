@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "../Camera/Camera.h"
+#include "../Geometry/Geometry.h"
+#include "../Light/PointLight.h"
+
+namespace rt {
+    // A mesh of the scene: a contiguous range of the scene's triangle array, and the
+    // range of the scene's levels of detail simplified from it, coarsest last
+    struct SceneObject {
+        std::uint32_t   FirstTriangle = 0;
+        std::uint32_t   TriangleCount = 0;
+        Vector3<float>  DiffuseColor;
+        std::uint32_t   FirstLod = 0;
+        std::uint32_t   LodCount = 0;
+    };
+
+    // A simplified copy of an object, a range of the scene's level-of-detail triangles
+    struct SceneLod {
+        std::uint32_t   FirstTriangle = 0;
+        std::uint32_t   TriangleCount = 0;
+        // How far the simplification may have moved the surface from the full mesh
+        float           Error = 0.f;
+    };
+
+    struct LodOptions {
+        // Objects with fewer triangles keep their full mesh only, 0 generates no levels
+        std::uint32_t   MinTriangles = 0;
+        // Triangles of each level relative to the level before
+        float           Ratio = 0.25f;
+        // Levels stop before they would fall below this many triangles
+        std::uint32_t   MinLevelTriangles = 64;
+    };
+
+    // Flat storage for a loaded scene. Objects, triangles and lights live in contiguous
+    // arrays addressed by index, owned by the scene alone. Whatever keeps the data takes
+    // the scene by rvalue, so any copy shows at the call site.
+    class Scene {
+    public:
+        Scene() = default;
+
+        // Appends an object whose triangles are added with AddTriangle until the next call
+        std::uint32_t   AddObject(Vector3<float> const& diffuseColor);
+        void            AddTriangle(Vertex const& v1, Vertex const& v2, Vertex const& v3);
+        void            AddLight(PointLight const& light);
+        void            SetCamera(Camera const& camera);
+        // Simplifies every object of at least options.MinTriangles triangles into nested levels
+        void            GenerateLods(LodOptions const& options);
+        // Frees spare capacity once loading is done
+        void            Shrink();
+        void            Clear();
+
+        std::vector<SceneObject> const& GetObjects() const;
+        std::vector<Triangle> const&    GetTriangles() const;
+        std::vector<SceneLod> const&    GetLods() const;
+        std::vector<Triangle> const&    GetLodTriangles() const;
+        std::vector<PointLight> const&  GetLights() const;
+        Camera const&                   GetCamera() const;
+        // Bytes held by the scene's arrays
+        std::size_t                     GetMemoryUsage() const;
+
+        void    Report(std::ostream& out) const;
+
+    private:
+        std::vector<SceneObject>    _objects;
+        std::vector<Triangle>       _triangles;
+        std::vector<SceneLod>       _lods;
+        std::vector<Triangle>       _lodTriangles;
+        std::vector<PointLight>     _lights;
+        Camera                      _camera;
+    };
+}  // namespace rt
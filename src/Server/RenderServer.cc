@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "../Render/TileRenderer.h"
+#include "RenderServer.h"
+
+namespace rt {
+    RenderServer::RenderServer(unsigned int threadCount, std::size_t cacheSize, AccelOptions const& accel,
+                               ShadingOptions const& shading) : _cache(cacheSize, accel, shading), _pool(threadCount),
+        _running(false), _maxQueueDepth(0), _completed(0), _failed(0) {
+    }
+
+    bool RenderServer::Listen(std::uint16_t port) {
+        // Scene paths come from the client, so only local clients are accepted
+        if (!_listener.Listen(port, true)) {
+            std::cerr << "Cannot listen on port " << port << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void RenderServer::Run() {
+        _started = std::chrono::steady_clock::now();
+        _running = true;
+        std::thread renderer(&RenderServer::_renderLoop, this);
+        std::list<std::unique_ptr<Connection>> connections;
+        while (_running) {
+            for (auto it = connections.begin(); it != connections.end();) {
+                if ((*it)->Finished) {
+                    (*it)->Thread.join();
+                    it = connections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (!_listener.WaitReadable(PollInterval)) {
+                continue;
+            }
+            auto connection = std::make_unique<Connection>();
+            connection->Link = _listener.Accept();
+            if (connection->Link.IsValid()) {
+                connection->Thread = std::thread(&RenderServer::_serve, this, std::ref(*connection));
+                connections.push_back(std::move(connection));
+            }
+        }
+        _pending.notify_all();
+        renderer.join();
+        for (auto& connection : connections) {
+            connection->Thread.join();
+        }
+        _listener.Close();
+    }
+
+    void RenderServer::Stop() {
+        _running = false;
+        _pending.notify_all();
+    }
+
+    void RenderServer::_serve(Connection& connection) {
+        Message request;
+        while (_running) {
+            if (!connection.Link.WaitReadable(PollInterval)) {
+                continue;
+            }
+            if (!request.Receive(connection.Link)) {
+                break;
+            }
+            bool sent = false;
+            switch (static_cast<ServerMessage>(request.GetType())) {
+                case ServerMessage::Render: {
+                    RenderRequest job;
+                    RenderReply reply;
+                    std::string error = "malformed render request";
+                    if (ReadRequest(request, job) && _submit(job, reply, error)) {
+                        Message result(static_cast<std::uint8_t>(ServerMessage::Result));
+                        WriteReply(result, reply);
+                        sent = result.Send(connection.Link);
+                    } else {
+                        Message failure(static_cast<std::uint8_t>(ServerMessage::Error));
+                        failure.WriteString(error);
+                        sent = failure.Send(connection.Link);
+                    }
+                    break;
+                }
+                case ServerMessage::Metrics:
+                case ServerMessage::Shutdown: {
+                    std::ostringstream report;
+                    Report(report);
+                    Message metrics(static_cast<std::uint8_t>(ServerMessage::MetricsReport));
+                    metrics.WriteString(report.str());
+                    sent = metrics.Send(connection.Link);
+                    if (static_cast<ServerMessage>(request.GetType()) == ServerMessage::Shutdown) {
+                        Stop();
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            if (!sent) {
+                break;
+            }
+        }
+        connection.Link.Close();
+        connection.Finished = true;
+    }
+
+    bool RenderServer::_submit(RenderRequest const& request, RenderReply& reply, std::string& error) {
+        if (request.Res.X == 0 || request.Res.Y == 0 || request.Spp == 0 || request.FOV <= 0.f || request.FOV >= 180.f) {
+            error = "invalid resolution, FOV or spp";
+            return false;
+        }
+        if (static_cast<std::size_t>(request.Res.X) * request.Res.Y > Message::MaxImagePixels) {
+            error = "image too large to send back";
+            return false;
+        }
+        auto job = std::make_shared<Job>();
+        job->Request = request;
+        job->Queued = std::chrono::steady_clock::now();
+        std::future<bool> done = job->Done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(job);
+            _maxQueueDepth = std::max(_maxQueueDepth, _queue.size());
+        }
+        _pending.notify_one();
+        if (!done.get()) {
+            error = job->Error;
+            return false;
+        }
+        reply = std::move(job->Reply);
+        return true;
+    }
+
+    void RenderServer::_renderLoop() {
+        while (true) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _pending.wait(lock, [this] { return !_queue.empty() || !_running; });
+                if (_queue.empty()) {
+                    return;
+                }
+                job = _queue.front();
+                _queue.pop_front();
+            }
+            auto const start = std::chrono::steady_clock::now();
+            bool const rendered = _render(*job);
+            auto const end = std::chrono::steady_clock::now();
+            job->Reply.QueueTime = std::chrono::duration<float, std::milli>(start - job->Queued).count();
+            job->Reply.RenderTime = std::chrono::duration<float, std::milli>(end - start).count();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (rendered) {
+                    ++_completed;
+                    _queueTime.Add(job->Reply.QueueTime);
+                    _renderTime.Add(job->Reply.RenderTime);
+                    _totalTime.Add(std::chrono::duration<float, std::milli>(end - job->Queued).count());
+                } else {
+                    ++_failed;
+                }
+            }
+            job->Done.set_value(rendered);
+        }
+    }
+
+    bool RenderServer::_render(Job& job) {
+        RenderRequest const& request = job.Request;
+        std::shared_ptr<Engine const> scene = _cache.Get(request.ScenePath, job.Reply.CacheHit);
+        if (!scene) {
+            job.Error = "cannot load scene " + request.ScenePath;
+            return false;
+        }
+        Camera camera = *scene->GetCamera();
+        if (request.HasPose) {
+            camera.SetPose(request.Pose);
+        }
+        camera.SetFOV(request.FOV);
+        camera.SetRes(request.Res);
+        job.Reply.Picture = Image(request.Res);
+        TileRenderer renderer(*scene, _pool);
+        renderer.Render(camera, Tile(0, 0, request.Res.X, request.Res.Y), request.Spp, job.Reply.Picture.Pixels.data(),
+                        job.Reply.Picture.GetStride());
+        return true;
+    }
+
+    void RenderServer::Report(std::ostream& out) const {
+        CacheStats const cache = _cache.GetStats();
+        std::lock_guard<std::mutex> lock(_mutex);
+        float const uptime = std::chrono::duration<float>(std::chrono::steady_clock::now() - _started).count();
+        out << std::fixed << std::setprecision(2)
+            << "uptime: " << uptime << " s, jobs: " << _completed << " done, " << _failed << " failed"
+            << ", queue depth: " << _queue.size() << " (max " << _maxQueueDepth << ")" << std::endl
+            << "scene cache: " << cache.Resident << " resident, " << cache.Hits << " hits, " << cache.Misses << " misses, "
+            << cache.Reloads << " reloads, " << cache.Evictions << " evictions, " << cache.LoadTime << " ms loading" << std::endl;
+        _queueTime.Report(out, "queue");
+        _renderTime.Report(out, "render");
+        _totalTime.Report(out, "total");
+    }
+
+    void RenderServer::Latency::Add(float time) {
+        History[Count++ % HistorySize] = time;
+    }
+
+    void RenderServer::Latency::Report(std::ostream& out, char const* name) const {
+        std::size_t const count = static_cast<std::size_t>(std::min<std::uint64_t>(Count, HistorySize));
+        if (count == 0) {
+            return;
+        }
+        std::vector<float> times(History.begin(), History.begin() + count);
+        std::sort(times.begin(), times.end());
+        float total = 0.f;
+        for (float time : times) {
+            total += time;
+        }
+        out << name << " ms mean/p50/p95/max: " << total / count << " / " << times[count / 2] << " / "
+            << times[std::min(count - 1, count * 95 / 100)] << " / " << times.back() << std::endl;
+    }
+}  // namespace rt
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include "../Net/Socket.h"
+#include "../Render/ThreadPool.h"
+#include "SceneCache.h"
+#include "ServerProtocol.h"
+
+namespace rt {
+    // Long-lived render process on a loopback port. Connections queue render jobs,
+    // one render thread works through them with the whole pool and scenes stay
+    // loaded in the cache between jobs. Scenes are built and shaded with the
+    // server's options, requests only choose the view.
+    class RenderServer {
+    public:
+        RenderServer(unsigned int threadCount, std::size_t cacheSize, AccelOptions const& accel, ShadingOptions const& shading);
+
+        bool    Listen(std::uint16_t port);
+        void    Run();
+        void    Stop();
+        void    Report(std::ostream& out) const;
+
+        static constexpr int            PollInterval = 100;
+        static constexpr std::size_t    HistorySize = 256;
+
+    private:
+        struct Job {
+            RenderRequest                           Request;
+            RenderReply                             Reply;
+            std::string                             Error;
+            std::chrono::steady_clock::time_point   Queued;
+            std::promise<bool>                      Done;
+        };
+
+        struct Connection {
+            Socket              Link;
+            std::thread         Thread;
+            std::atomic<bool>   Finished{false};
+        };
+
+        struct Latency {
+            std::array<float, HistorySize>  History{};
+            std::uint64_t                   Count = 0;
+
+            void    Add(float time);
+            void    Report(std::ostream& out, char const* name) const;
+        };
+
+        SceneCache                                  _cache;
+        ThreadPool                                  _pool;
+        Socket                                      _listener;
+        std::atomic<bool>                           _running;
+        std::chrono::steady_clock::time_point       _started;
+
+        mutable std::mutex                          _mutex;
+        std::condition_variable                     _pending;
+        std::deque<std::shared_ptr<Job>>           _queue;
+        std::size_t                                 _maxQueueDepth;
+        std::size_t                                 _completed;
+        std::size_t                                 _failed;
+        Latency                                     _queueTime;
+        Latency                                     _renderTime;
+        Latency                                     _totalTime;
+
+        void    _serve(Connection& connection);
+        bool    _submit(RenderRequest const& request, RenderReply& reply, std::string& error);
+        void    _renderLoop();
+        bool    _render(Job& job);
+    };
+}  // namespace rt
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sys/stat.h>
+#include "../Loader/AssimpLoader.h"
+#include "SceneCache.h"
+
+namespace rt {
+    SceneCache::SceneCache(std::size_t capacity, AccelOptions const& accel, ShadingOptions const& shading)
+        : _capacity(std::max<std::size_t>(capacity, 1)), _accel(accel), _shading(shading) {
+    }
+
+    std::shared_ptr<Engine const> SceneCache::Get(std::string const& path, bool& hit) {
+        hit = false;
+        std::int64_t modTime = 0;
+        if (!GetModTime(path, modTime)) {
+            std::cerr << "Cannot stat scene " << path << std::endl;
+            return nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto const found = _index.find(path);
+            if (found != _index.end()) {
+                if (found->second->ModTime == modTime) {
+                    _entries.splice(_entries.begin(), _entries, found->second);
+                    ++_stats.Hits;
+                    hit = true;
+                    return found->second->Scene;
+                }
+                // Stale: the file changed since it was loaded
+                _entries.erase(found->second);
+                _index.erase(found);
+                ++_stats.Reloads;
+            }
+            ++_stats.Misses;
+        }
+
+        auto const start = std::chrono::steady_clock::now();
+        AssimpLoader loader;
+        if (!loader.LoadFile(path)) {
+            return nullptr;
+        }
+        auto engine = std::make_shared<Engine>(loader.TakeScene(), _accel);
+        engine->SetShading(_shading);
+        std::shared_ptr<Engine const> scene = std::move(engine);
+        float const loadTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.LoadTime += loadTime;
+        if (_index.find(path) == _index.end()) {
+            _entries.push_front(Entry{path, modTime, scene});
+            _index[path] = _entries.begin();
+            while (_entries.size() > _capacity) {
+                _index.erase(_entries.back().Path);
+                _entries.pop_back();
+                ++_stats.Evictions;
+            }
+        }
+        _stats.Resident = _entries.size();
+        return scene;
+    }
+
+    CacheStats SceneCache::GetStats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    bool GetModTime(std::string const& path, std::int64_t& modTime) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            return false;
+        }
+        modTime = static_cast<std::int64_t>(info.st_mtime);
+        return true;
+    }
+}  // namespace rt
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../Engine/Engine.h"
+
+namespace rt {
+    struct CacheStats {
+        std::size_t     Hits = 0;
+        std::size_t     Misses = 0;
+        std::size_t     Reloads = 0;
+        std::size_t     Evictions = 0;
+        std::size_t     Resident = 0;
+        float           LoadTime = 0.f;
+    };
+
+    // Keeps the most recently used scenes loaded. Entries are keyed by path and
+    // modification time, so a scene edited on disk is loaded again on next use.
+    // Every scene is built and shaded with the same options.
+    class SceneCache {
+    public:
+        SceneCache(std::size_t capacity, AccelOptions const& accel, ShadingOptions const& shading);
+
+        std::shared_ptr<Engine const>   Get(std::string const& path, bool& hit);
+        CacheStats                      GetStats() const;
+
+    private:
+        struct Entry {
+            std::string                     Path;
+            std::int64_t                    ModTime;
+            std::shared_ptr<Engine const>   Scene;
+        };
+
+        mutable std::mutex                                                  _mutex;
+        std::size_t                                                         _capacity;
+        AccelOptions                                                        _accel;
+        ShadingOptions                                                      _shading;
+        std::list<Entry>                                                    _entries;
+        std::unordered_map<std::string, std::list<Entry>::iterator>         _index;
+        CacheStats                                                          _stats;
+    };
+
+    bool    GetModTime(std::string const& path, std::int64_t& modTime);
+}  // namespace rt
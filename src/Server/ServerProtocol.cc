@@ -0,0 +1,36 @@
+#include "ServerProtocol.h"
+
+namespace rt {
+    void WriteRequest(Message& message, RenderRequest const& request) {
+        message.WriteString(request.ScenePath);
+        message.Write(static_cast<std::uint8_t>(request.HasPose)).Write(request.Pose).Write(request.Res)
+            .Write(request.FOV).Write(request.Spp);
+    }
+
+    bool ReadRequest(Message& message, RenderRequest& request) {
+        std::uint8_t hasPose = 0;
+        if (!message.ReadString(request.ScenePath) || !message.Read(hasPose) || !message.Read(request.Pose)
+            || !message.Read(request.Res) || !message.Read(request.FOV) || !message.Read(request.Spp)) {
+            return false;
+        }
+        request.HasPose = hasPose != 0;
+        return true;
+    }
+
+    void WriteReply(Message& message, RenderReply const& reply) {
+        message.Write(reply.Picture.Res).Write(reply.QueueTime).Write(reply.RenderTime)
+            .Write(static_cast<std::uint8_t>(reply.CacheHit));
+        message.WriteBytes(reply.Picture.Pixels.data(), reply.Picture.Pixels.size());
+    }
+
+    bool ReadReply(Message& message, RenderReply& reply) {
+        Vector2<unsigned int> res;
+        std::uint8_t cacheHit = 0;
+        if (!message.Read(res) || !message.Read(reply.QueueTime) || !message.Read(reply.RenderTime) || !message.Read(cacheHit)) {
+            return false;
+        }
+        reply.Picture = Image(res);
+        reply.CacheHit = cacheHit != 0;
+        return message.ReadBytes(reply.Picture.Pixels.data(), reply.Picture.Pixels.size());
+    }
+}  // namespace rt
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "../Camera/Camera.h"
+#include "../Net/Message.h"
+#include "../Render/Image.h"
+#include "../Vector/Vector2.h"
+
+namespace rt {
+    enum class ServerMessage : std::uint8_t {
+        Render = 1,
+        Result,
+        Metrics,
+        MetricsReport,
+        Shutdown,
+        Error
+    };
+
+    // Scene paths are resolved by the server. Without a pose the scene's own camera is used.
+    struct RenderRequest {
+        std::string             ScenePath;
+        bool                    HasPose = false;
+        CameraPose              Pose;
+        Vector2<unsigned int>   Res;
+        float                   FOV = 0.f;
+        std::uint32_t           Spp = 1;
+    };
+
+    struct RenderReply {
+        Image       Picture;
+        float       QueueTime = 0.f;
+        float       RenderTime = 0.f;
+        bool        CacheHit = false;
+    };
+
+    void    WriteRequest(Message& message, RenderRequest const& request);
+    bool    ReadRequest(Message& message, RenderRequest& request);
+    void    WriteReply(Message& message, RenderReply const& reply);
+    bool    ReadReply(Message& message, RenderReply& reply);
+}  // namespace rt
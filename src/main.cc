@@ -3,41 +3,18 @@
 #include <SFML/Graphics.hpp>
 #include <cstring>
 #include <regex>
+#include <string>
+#include "App/Modes.h"
+#include "App/Options.h"
 #include "Engine/Constant.h"
 #include "Loader/AssimpLoader.h"
 #include "Camera/Camera.h"
+#include "Camera/CameraPath.h"
 #include "Engine/Engine.h"
+#include "Engine/Memory.h"
+#include "Render/Renderer.h"
 #include "Vector/Vector2.h"
 
-rt::Vector2<unsigned int> res{};
-std::size_t size{};
-std::vector<rt::Color> pixels{};
-
-std::mt19937 gen;
-std::normal_distribution<double> disY;
-std::normal_distribution<double> disX;
-
-void Init() {
-    size = res.Y * res.X;
-    pixels = std::vector<rt::Color>(size, rt::Color(0x000000ff));
-    disY = std::normal_distribution<double>(res.Y / 2, res.Y / 2);
-    disX = std::normal_distribution<double>(res.X / 2, res.X / 2);
-}
-
-void Flush() {
-    pixels.clear();
-    pixels.reserve(size);
-    pixels.resize(size, rt::Color(0x000000ff));
-}
-
-void Execute(rt::Engine& engine) {
-    size_t current = (int)disY(gen) * rt::Constant::DefaultScreenWidth + (int)disX(gen);
-    current = current % size;
-
-    rt::Color color = engine.Raytrace(rt::Vector2<unsigned int>(current % res.X, current / res.X));
-    pixels[current] = color;
-}
-
 class Demo {
 public:
     Demo(rt::Camera* camera) : camera_(camera), launched_(false) {
@@ -52,65 +29,82 @@ public:
     void TurnOff() {
         launched_ = false;
     }
-    void Run() {
+    bool Run() {
         if (launched_) {
             if (counter_++ % 5 == 0) {
-                if ((counter_ < 100) || (counter_ > 300)) {
-                    Flush();
-                    camera_->TurnLeft();
-                    camera_->MoveRight();
-                    camera_->MoveRight();
-                    camera_->MoveRight();
-                } else {
-                    Flush();
-                    camera_->TurnRight();
-                    camera_->MoveLeft();
-                    camera_->MoveLeft();
-                    camera_->MoveLeft();
-                }
-                if (counter_ >= 400) {
-                    counter_ = 0;
-                }
+                rt::CameraPath::StepDemo(*camera_, move_++);
+                return true;
             }
         }
+        return false;
     }
 
 private:
-    int counter_ = 0;
+    unsigned int counter_ = 0;
+    std::size_t move_ = 0;
     rt::Camera* camera_ = nullptr;
     bool launched_ = false;
 };
 
-void displayToScreen(rt::Engine &engine, rt::Vector2<unsigned int> const& res) {
+void uploadFrame(sf::Texture& texture, rt::Frame const& frame, std::uint64_t since,
+                 std::vector<rt::Tile>& regions, std::vector<std::uint8_t>& staging) {
+    frame.DirtyRegions(since, regions);
+    std::size_t const stride = static_cast<std::size_t>(frame.Res.X) * 4;
+    for (auto const& region : regions) {
+        std::uint8_t const* src = &frame.Pixels[region.Y * stride + region.X * 4];
+        if (region.Width != frame.Res.X) {
+            std::size_t const rowSize = static_cast<std::size_t>(region.Width) * 4;
+            staging.resize(rowSize * region.Height);
+            for (unsigned int row = 0; row < region.Height; ++row) {
+                std::memcpy(&staging[row * rowSize], src + row * stride, rowSize);
+            }
+            src = staging.data();
+        }
+        texture.update(src, sf::Vector2u{region.Width, region.Height}, sf::Vector2u{region.X, region.Y});
+    }
+}
+
+void displayToScreen(rt::Engine &engine, rt::Vector2<unsigned int> const& res, rt::Options const& options) {
     sf::VideoMode video_mode{sf::Vector2u{res.X, res.Y}};
     sf::RenderWindow window{video_mode, "RayTracer"};
-    uint8_t* frame = new uint8_t[window.getSize().x * window.getSize().y * 4];
-    std::fill_n(frame, window.getSize().x * window.getSize().y * 4, 255);
+    window.setFramerateLimit(60);
     sf::Texture texture;
     texture.create(window.getSize());
+    texture.setSmooth(true);
     sf::Sprite sprite(texture);
+    rt::Vector2<unsigned int> textureRes = res;
 
     rt::Camera* camera = engine.GetCamera();
     Demo demo{camera};
 
-    while (window.isOpen()) {
-        std::size_t i = 0;
-
-        demo.Run();
+    rt::Renderer renderer{engine, options.Threads};
+    renderer.SetTargetFrameTime(options.TargetFrameTime);
+    renderer.GetFrameBudget().SetTargetFps(options.Fps);
+    rt::CameraState& cameraState = renderer.GetCameraState();
+    rt::TripleBuffer<rt::Frame>& frames = renderer.GetFrames();
+    rt::Profiler& profiler = renderer.GetProfiler();
+    std::uint64_t uploaded = 0;
+    std::vector<rt::Tile> regions;
+    std::vector<std::uint8_t> staging;
+    renderer.Start();
 
-        for (int cnt = 0; cnt < 10'000; ++cnt) {
-            Execute(engine);
-        }
-
-        for (auto& pixel : pixels) {
-            rt::Color_Component const& components = pixel.GetColor();
-            frame[i] = components.rgba.r;
-            frame[i + 1] = components.rgba.g;
-            frame[i + 2] = components.rgba.b;
-            i = i + 4;
+    while (window.isOpen()) {
+        bool moved = demo.Run();
+
+        if (frames.Update()) {
+            rt::Profiler::Scope scope(profiler, rt::Profiler::Upload);
+            rt::Vector2<unsigned int> const& frameRes = frames.Front().Res;
+            if (frameRes != textureRes) {
+                // Internal resolution changed, stretch the new texture over the window
+                textureRes = frameRes;
+                texture.create(sf::Vector2u{frameRes.X, frameRes.Y});
+                sprite.setTexture(texture, true);
+                sprite.setScale(sf::Vector2f{static_cast<float>(res.X) / frameRes.X, static_cast<float>(res.Y) / frameRes.Y});
+                uploaded = 0;
+            }
+            uploadFrame(texture, frames.Front(), uploaded, regions, staging);
+            uploaded = frames.Front().Index;
         }
-
-        texture.update(frame);
         window.clear();
         window.draw(sprite);
         window.display();
@@ -122,34 +116,39 @@ void displayToScreen(rt::Engine &engine, rt::Vector2<unsigned int> const& res) {
             }
             if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::W) {
                 std::cout << camera->GetPos() << std::endl;
-                Flush();
                 camera->MoveForward();
+                moved = true;
             }
             if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::A) {
                 std::cout << camera->GetPos() << std::endl;
-                Flush();
                 camera->MoveLeft();
+                moved = true;
             }
             if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::S) {
                 std::cout << camera->GetPos() << std::endl;
-                Flush();
                 camera->MoveBack();
+                moved = true;
             }
             if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::D) {
                 std::cout << camera->GetPos() << std::endl;
-                Flush();
                 camera->MoveRight();
+                moved = true;
             }
 
             if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Left) {
                 std::cout << camera->GetPos() << std::endl;
-                Flush();
                 camera->TurnLeft();
+                moved = true;
             }
             if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Right) {
                 std::cout << camera->GetPos() << std::endl;
-                Flush();
                 camera->TurnRight();
+                moved = true;
+            }
+
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::P) {
+                profiler.Report(std::cout);
+                renderer.GetFrameBudget().Report(std::cout);
             }
 
             if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Space) {
@@ -160,28 +159,73 @@ void displayToScreen(rt::Engine &engine, rt::Vector2<unsigned int> const& res) {
                 }
             }
         }
+
+        if (moved) {
+            cameraState.Store(camera->GetPose());
+        }
     }
+
+    renderer.Stop();
+    profiler.Report(std::cout);
+    renderer.GetFrameBudget().Report(std::cout);
 }
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " scene.dae" << std::endl;
+    rt::Options options;
+    if (!rt::ParseOptions(argc, argv, options)) {
+        rt::PrintUsage(std::cerr, argv[0]);
         return 1;
     }
+    rt::SetHugePages(options.HugePageMode);
+    if (options.RunMode == rt::Mode::Coordinator) {
+        return rt::RunCoordinator(options);
+    }
+    if (options.RunMode == rt::Mode::Worker) {
+        return rt::RunWorker(options);
+    }
+    if (options.RunMode == rt::Mode::Server) {
+        return rt::RunServer(options);
+    }
+    if (options.RunMode == rt::Mode::Client) {
+        return rt::RunClient(options);
+    }
+    if (options.RunMode == rt::Mode::Batch) {
+        return rt::RunBatch(options);
+    }
+    if (options.RunMode == rt::Mode::Animate) {
+        return rt::RunAnimation(options);
+    }
+    if (options.RunMode == rt::Mode::BvhReport) {
+        return rt::RunBvhReport(options);
+    }
+    if (options.RunMode == rt::Mode::Heatmap) {
+        return rt::RunHeatmap(options);
+    }
+    if (options.RunMode == rt::Mode::NumaReport) {
+        return rt::RunNumaReport(options);
+    }
 
     rt::AssimpLoader loader;
+    loader.SetLodOptions(options.Lod);
 
-    std::cout << "Loading scene " << argv[1] << "..." << std::endl;
-    if (!loader.LoadFile(argv[1])) {
+    std::cout << "Loading scene " << options.Scene << "..." << std::endl;
+    if (!loader.LoadFile(options.Scene)) {
         return 1;
     }
 
-    rt::Engine engine{loader};
+    loader.GetScene().Report(std::cout);
+    rt::Engine engine{loader.TakeScene(), options.Accel};
+    rt::BVH::Report(engine.GetBVHStats(), std::cout);
+    rt::ReportMemory(std::cout);
+    engine.SetShading(rt::GetShadingOptions(options));
+    engine.ReportKernel(std::cout);
+    engine.GetCamera()->SetRes(options.Res);
+    engine.GetCamera()->SetFOV(options.FOV);
+    engine.SetLevelOfDetail(options.LodPixels * engine.GetCamera()->GetPixelAngle());
+    engine.ReportLods(std::cout);
 
-    //rt::Vector2<unsigned int> res = engine.GetRes();
-    res = engine.GetRes();
-    Init();
+    rt::Vector2<unsigned int> res = engine.GetRes();
 
-    displayToScreen(engine, res);
+    displayToScreen(engine, res, options);
     return 0;
 }
@@ -0,0 +1,212 @@
+// Golden-image and throughput regression run. Renders the sample scenes with a fixed
+// camera (the library is built with RT_TESTING_ENV, which removes the sub-pixel jitter),
+// compares every image to its reference and the rays/s to a per-machine baseline.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include "Engine/Engine.h"
+#include "Loader/AssimpLoader.h"
+#include "Render/Image.h"
+#include "Render/ThreadPool.h"
+#include "Render/TileRenderer.h"
+
+namespace rt {
+    namespace {
+        struct Arguments {
+            std::string     Scenes;
+            std::string     Golden;
+            std::string     Baseline;
+            unsigned int    Tolerance = 2;
+            float           MaxDrop = 10.f;
+            bool            Update = false;
+            unsigned int    Threads = std::thread::hardware_concurrency();
+        };
+
+        struct Case {
+            char const*     Scene;
+            char const*     Name;
+            AOOptions       AO;
+        };
+
+        constexpr unsigned int  Width = 320;
+        constexpr unsigned int  Height = 240;
+        constexpr unsigned int  Runs = 5;
+        // Tells ctest the run compared nothing, see SKIP_RETURN_CODE in CMakeLists.txt
+        constexpr int           SkipCode = 77;
+
+        bool parseArguments(int argc, char** argv, Arguments& arguments) {
+            if (argc < 4) {
+                return false;
+            }
+            arguments.Scenes = argv[1];
+            arguments.Golden = argv[2];
+            arguments.Baseline = argv[3];
+            for (int i = 4; i < argc; ++i) {
+                std::string const arg = argv[i];
+                bool const hasValue = i + 1 < argc;
+                if (arg == "--tolerance" && hasValue) {
+                    arguments.Tolerance = std::strtoul(argv[++i], nullptr, 10);
+                } else if (arg == "--max-drop" && hasValue) {
+                    arguments.MaxDrop = std::strtof(argv[++i], nullptr);
+                } else if (arg == "--threads" && hasValue) {
+                    arguments.Threads = std::strtoul(argv[++i], nullptr, 10);
+                } else if (arg == "--update") {
+                    arguments.Update = true;
+                } else {
+                    return false;
+                }
+            }
+            return arguments.Threads > 0;
+        }
+
+        std::map<std::string, double> readBaseline(std::string const& path) {
+            std::map<std::string, double> baseline;
+            std::ifstream in(path);
+            std::string name;
+            double raysPerSecond = 0.0;
+            while (in >> name >> raysPerSecond) {
+                baseline[name] = raysPerSecond;
+            }
+            return baseline;
+        }
+
+        bool writeBaseline(std::string const& path, std::map<std::string, double> const& baseline) {
+            std::ofstream out(path);
+            for (auto const& entry : baseline) {
+                out << entry.first << " " << std::fixed << std::setprecision(0) << entry.second << "\n";
+            }
+            if (!out) {
+                std::cerr << "Cannot write baseline " << path << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // Counts the pixels where a channel differs from the reference by more than tolerance
+        bool compareImages(Image const& image, Image const& golden, unsigned int tolerance, std::ostream& out) {
+            if (image.Res.X != golden.Res.X || image.Res.Y != golden.Res.Y) {
+                out << "size " << image.Res.X << "x" << image.Res.Y << " differs from reference " << golden.Res.X << "x"
+                    << golden.Res.Y;
+                return false;
+            }
+            std::size_t differing = 0;
+            int maxDifference = 0;
+            for (std::size_t i = 0; i < image.Pixels.size(); i += 4) {
+                int pixelDifference = 0;
+                for (std::size_t channel = 0; channel < 3; ++channel) {
+                    pixelDifference = std::max(pixelDifference, std::abs(image.Pixels[i + channel] - golden.Pixels[i + channel]));
+                }
+                maxDifference = std::max(maxDifference, pixelDifference);
+                differing += pixelDifference > static_cast<int>(tolerance);
+            }
+            out << differing << " pixel(s) beyond tolerance, max channel difference " << maxDifference;
+            return differing == 0;
+        }
+
+        // Renders the case Runs times and returns the best rays/s, leaving the last frame in image
+        double renderCase(Case const& test, Arguments const& arguments, ThreadPool& pool, Image& image) {
+            AssimpLoader loader;
+            if (!loader.LoadFile(arguments.Scenes + "/" + test.Scene)) {
+                return 0.0;
+            }
+            AccelOptions accel;
+            accel.BuildThreads = arguments.Threads;
+            Engine engine{loader.TakeScene(), accel};
+            engine.SetAmbientOcclusion(test.AO);
+            Camera camera = *engine.GetCamera();
+            camera.SetRes(Vector2<unsigned int>(Width, Height));
+            image = Image(Vector2<unsigned int>(Width, Height));
+            TileRenderer renderer(engine, pool);
+            float best = 0.f;
+            for (unsigned int run = 0; run < Runs; ++run) {
+                auto const start = std::chrono::steady_clock::now();
+                renderer.Render(camera, Tile(0, 0, Width, Height), 1, image.Pixels.data(), image.GetStride());
+                float const seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+                best = run == 0 ? seconds : std::min(best, seconds);
+            }
+            return best > 0.f ? static_cast<double>(Width) * Height / best : 0.0;
+        }
+
+        int runRegression(Arguments const& arguments) {
+            static Case const cases[] = {
+                {"Cube.dae", "Cube", AOOptions()},
+                {"Ico.dae", "Ico", AOOptions()},
+                {"Cube.dae", "Cube_ao", AOOptions{8, 1.f}},
+                {"Ico.dae", "Ico_ao", AOOptions{8, 1.f}},
+            };
+            ThreadPool pool(arguments.Threads);
+            std::map<std::string, double> baseline = readBaseline(arguments.Baseline);
+            bool passed = true;
+            bool skipped = false;
+            bool baselineChanged = false;
+            for (Case const& test : cases) {
+                Image image;
+                double const raysPerSecond = renderCase(test, arguments, pool, image);
+                if (raysPerSecond <= 0.0) {
+                    std::cout << test.Name << ": FAILED, scene did not load" << std::endl;
+                    passed = false;
+                    continue;
+                }
+                std::cout << test.Name << ": ";
+
+                std::string const goldenPath = arguments.Golden + "/" + test.Name + ".ppm";
+                Image golden;
+                if (arguments.Update) {
+                    std::error_code error;
+                    std::filesystem::create_directories(arguments.Golden, error);
+                    passed = image.WritePPM(goldenPath) && passed;
+                    std::cout << "reference image recorded";
+                } else if (!std::ifstream(goldenPath)) {
+                    std::cout << "no reference image, SKIPPED";
+                    skipped = true;
+                } else if (!golden.ReadPPM(goldenPath) || !compareImages(image, golden, arguments.Tolerance, std::cout)) {
+                    std::cout << " (FAILED)";
+                    passed = false;
+                }
+
+                std::cout << std::fixed << std::setprecision(2) << ", " << raysPerSecond / 1e6 << " M rays/s";
+                auto const reference = baseline.find(test.Name);
+                if (arguments.Update || reference == baseline.end()) {
+                    baseline[test.Name] = raysPerSecond;
+                    baselineChanged = true;
+                    std::cout << " recorded as baseline" << std::endl;
+                    continue;
+                }
+                float const change = static_cast<float>(100.0 * (raysPerSecond / reference->second - 1.0));
+                std::cout << " (" << std::showpos << change << std::noshowpos << "% against baseline "
+                          << reference->second / 1e6 << ")";
+                if (change < -arguments.MaxDrop) {
+                    std::cout << " FAILED, more than " << arguments.MaxDrop << "% slower";
+                    passed = false;
+                }
+                std::cout << std::endl;
+            }
+            if (baselineChanged && !writeBaseline(arguments.Baseline, baseline)) {
+                passed = false;
+            }
+            if (!passed) {
+                std::cout << "FAILED" << std::endl;
+                return 1;
+            }
+            std::cout << (skipped ? "SKIPPED, record the reference images with --update" : "PASSED") << std::endl;
+            return skipped ? SkipCode : 0;
+        }
+    }
+}  // namespace rt
+
+int main(int argc, char** argv) {
+    rt::Arguments arguments;
+    if (!rt::parseArguments(argc, argv, arguments)) {
+        std::cerr << "Usage: " << argv[0] << " SCENES_DIR GOLDEN_DIR BASELINE.txt [--tolerance N] [--max-drop PERCENT]"
+                  << " [--threads N] [--update]" << std::endl;
+        return 2;
+    }
+    return rt::runRegression(arguments);
+}